@@ -34,7 +34,7 @@ int main(int argc, char **argv) {
     if(VFS::mount("/", "m3fs") != Errors::NONE)
         exitmsg("Mounting root-fs failed");
 
-    FileRef file(argv[1], FILE_R);
+    FileRef file(argv[1], FILE_R | FILE_READAHEAD);
     if(Errors::occurred())
         exitmsg("open of " << argv[1] << " failed");
     cycles_t end1 = Time::stop(0);
@@ -37,7 +37,7 @@ int main(int argc, char **argv) {
         exitmsg("Mounting root-fs failed");
 
     for(int i = 0; i < repeats; ++i) {
-        FileRef file(argv[1], FILE_R);
+        FileRef file(argv[1], FILE_R | FILE_READAHEAD);
         if(Errors::occurred())
             exitmsg("open of " << argv[1] << " failed");
 
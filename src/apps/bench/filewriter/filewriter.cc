@@ -41,7 +41,7 @@ int main(int argc, char **argv) {
         exitmsg("Mounting root-fs failed");
 
     for(int i = 0; i < repeats; ++i) {
-        FileRef file(argv[1], FILE_W | FILE_TRUNC | FILE_CREATE);
+        FileRef file(argv[1], FILE_W | FILE_TRUNC | FILE_CREATE | FILE_WRBEHIND);
         if(Errors::occurred())
             exitmsg("open of " << argv[1] << " failed");
 
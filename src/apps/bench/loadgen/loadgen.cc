@@ -76,8 +76,7 @@ public:
         add_operation(LoadGen::START, &ReqHandler::start);
         add_operation(LoadGen::RESPONSE, &ReqHandler::response);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&ReqHandler::handle_message, this, _1));
+        _rgate.start<base_class_t, &base_class_t::handle_message>(this);
     }
 
     virtual Errors::Code open(LoadGenSession **sess, capsel_t srv_sel, word_t) override {
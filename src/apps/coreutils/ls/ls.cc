@@ -65,7 +65,6 @@ static bool compareEntries(const LSFile &a,const LSFile &b) {
 }
 
 int main(int argc, char **argv) {
-    char path[256];
     if(argc < 2)
         exitmsg("Usage: " << argv[0] << " [-ila] <path>");
 
@@ -112,14 +111,12 @@ int main(int argc, char **argv) {
             total++;
     }
 
-    // collect file info
+    // collect file info; the directory listing includes it
     LSFile *files = new LSFile[total];
     dir.reset();
-    for(size_t i = 0; dir.readdir(e); ) {
+    for(size_t i = 0; i < total && dir.readdir(e, info); ) {
         if(showall || e.name[0] != '.') {
-            OStringStream os(path, sizeof(path));
-            os << dirname << "/" << e.name;
-            VFS::stat(os.str(), files[i].info);
+            files[i].info = info;
             strncpy(files[i].name, e.name, sizeof(files[i].name));
             files[i].name[sizeof(files[i].name) - 1] = '\0';
             i++;
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#include <base/Common.h>
+#include <base/util/Profile.h>
+#include <base/Env.h>
+#include <base/Panic.h>
+
+#include <m3/com/GateStream.h>
+#include <m3/stream/Standard.h>
+
+#include <functional>
+
+#include "../cppbench.h"
+
+using namespace m3;
+
+struct Counter {
+    explicit Counter() : count() {
+    }
+
+    void handle(GateIStream &) {
+        count++;
+    }
+
+    ulong count;
+};
+
+static void run_loop(SendGate &sgate, Counter &cnt, unsigned id) {
+    Profile pr;
+    cout << pr.run_with_id([&sgate, &cnt] {
+        ulong prev = cnt.count;
+        send_vmsg(sgate, 0);
+        while(cnt.count == prev)
+            env()->workloop()->tick();
+    }, id) << "\n";
+}
+
+NOINLINE static void bound_handler() {
+    using std::placeholders::_1;
+
+    RecvGate rgate = RecvGate::create(nextlog2<512>::val, nextlog2<64>::val);
+    SendGate sgate = SendGate::create(&rgate);
+    Counter cnt;
+
+    rgate.start(std::bind(&Counter::handle, &cnt, _1));
+    cout << "std::function handler: ";
+    run_loop(sgate, cnt, 0x70);
+    rgate.stop();
+}
+
+NOINLINE static void templ_handler() {
+    RecvGate rgate = RecvGate::create(nextlog2<512>::val, nextlog2<64>::val);
+    SendGate sgate = SendGate::create(&rgate);
+    Counter cnt;
+
+    rgate.start<Counter, &Counter::handle>(&cnt);
+    cout << "templated handler: ";
+    run_loop(sgate, cnt, 0x71);
+    rgate.stop();
+}
+
+void bhandler() {
+    RUN_BENCH(bound_handler);
+    RUN_BENCH(templ_handler);
+}
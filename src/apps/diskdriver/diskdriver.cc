@@ -71,8 +71,7 @@ public:
         add_operation(Disk::READ, &DiskRequestHandler::read);
         add_operation(Disk::WRITE, &DiskRequestHandler::write);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&DiskRequestHandler::handle_message, this, _1));
+        _rgate.start<base_class, &base_class::handle_message>(this);
     }
 
     virtual Errors::Code obtain(DiskSrvSession *sess, KIF::Service::ExchangeData &data) override {
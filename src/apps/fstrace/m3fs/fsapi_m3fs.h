@@ -98,7 +98,8 @@ public:
         }
         else {
             auto nfile = m3::VFS::open(add_prefix(args->name),
-                                       args->flags | (_data ? 0 : m3::FILE_NODATA) | m3::FILE_NOSESS);
+                                       args->flags | (_data ? 0 : m3::FILE_NODATA) |
+                                       m3::FILE_NOSESS | m3::FILE_WRBEHIND);
             if(m3::Errors::occurred()) {
                 m3::VFS::close(nfile);
                 if(args->fd != -1)
@@ -127,8 +128,11 @@ public:
             exitmsg("Using uninitialized file @ " << args->fd);
     }
 
-    virtual void fsync(const fsync_args_t *, int ) override {
-        // TODO not implemented
+    virtual void fsync(const fsync_args_t *args, int lineNo) override {
+        checkFd(args->fd);
+        int res = m3::VPE::self().fds()->get(_fdMap[args->fd])->sync();
+        if ((res == m3::Errors::NONE) != (args->err == 0))
+            THROW1(ReturnValueException, res, args->err, lineNo);
     }
 
     virtual ssize_t read(int fd, void *buffer, size_t size) override {
@@ -162,14 +166,36 @@ public:
 
     virtual ssize_t pread(int fd, void *buffer, size_t size, off_t offset) override {
         checkFd(fd);
-        m3::VPE::self().fds()->get(_fdMap[fd])->seek(static_cast<size_t>(offset), M3FS_SEEK_SET);
-        return read(fd, buffer, size);
+        m3::File *file = m3::VPE::self().fds()->get(_fdMap[fd]);
+        char *buf = reinterpret_cast<char*>(buffer);
+        size_t off = static_cast<size_t>(offset);
+        while(size > 0) {
+            ssize_t res = file->pread(buf, size, off);
+            if(res < 0)
+                return m3::Errors::last;
+            if(res == 0)
+                break;
+            size -= static_cast<size_t>(res);
+            off += static_cast<size_t>(res);
+            buf += res;
+        }
+        return buf - reinterpret_cast<char*>(buffer);
     }
 
     virtual ssize_t pwrite(int fd, const void *buffer, size_t size, off_t offset) override {
         checkFd(fd);
-        m3::VPE::self().fds()->get(_fdMap[fd])->seek(static_cast<size_t>(offset), M3FS_SEEK_SET);
-        return write(fd, buffer, size);
+        m3::File *file = m3::VPE::self().fds()->get(_fdMap[fd]);
+        const char *buf = reinterpret_cast<const char*>(buffer);
+        size_t off = static_cast<size_t>(offset);
+        while(size > 0) {
+            ssize_t res = file->pwrite(buf, size, off);
+            if(res <= 0)
+                return -static_cast<ssize_t>(m3::Errors::last);
+            size -= static_cast<size_t>(res);
+            off += static_cast<size_t>(res);
+            buf += res;
+        }
+        return buf - reinterpret_cast<const char*>(buffer);
     }
 
     virtual void lseek(const lseek_args_t *args, UNUSED int lineNo) override {
@@ -20,6 +20,7 @@
 #include <base/col/SList.h>
 #include <base/DTU.h>
 
+#include "mem/SlabCache.h"
 #include "Gate.h"
 
 namespace kernel {
@@ -27,7 +28,7 @@ namespace kernel {
 struct Timeout;
 
 class SendQueue {
-    struct Entry : public m3::SListItem {
+    struct Entry : public SlabObject<Entry>, public m3::SListItem {
         explicit Entry(uint64_t _id, SendGate *_sgate, const void *_msg, size_t _size)
             : SListItem(),
               id(_id),
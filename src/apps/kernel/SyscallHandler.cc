@@ -16,6 +16,7 @@
 
 #include <base/tracing/Tracing.h>
 #include <base/log/Kernel.h>
+#include <base/stream/OStringStream.h>
 #include <base/util/Math.h>
 #include <base/Init.h>
 #include <base/Panic.h>
@@ -38,6 +39,36 @@ namespace kernel {
 
 ulong SyscallHandler::_vpes_per_ep[SyscallHandler::SYSC_REP_COUNT];
 SyscallHandler::handler_func SyscallHandler::_callbacks[m3::KIF::Syscall::COUNT];
+SyscallHandler::OpStats SyscallHandler::_stats[m3::KIF::Syscall::COUNT];
+
+static const char *sysc_names[] = {
+    "PAGEFAULT",
+    "CREATE_SRV",
+    "CREATE_SESS",
+    "CREATE_RGATE",
+    "CREATE_SGATE",
+    "CREATE_MGATE",
+    "CREATE_MAP",
+    "CREATE_VPEGRP",
+    "CREATE_VPE",
+    "ACTIVATE",
+    "SRV_CTRL",
+    "VPE_CTRL",
+    "VPE_WAIT",
+    "DERIVE_MEM",
+    "OPEN_SESS",
+    "DELEGATE",
+    "OBTAIN",
+    "EXCHANGE",
+    "REVOKE",
+    "FORWARD_MSG",
+    "FORWARD_MEM",
+    "FORWARD_REPLY",
+    "NOOP",
+    "SYSC_STATS",
+};
+
+static_assert(ARRAY_SIZE(sysc_names) == m3::KIF::Syscall::COUNT, "Syscall names incomplete");
 
 #define LOG_SYS(vpe, sysname, expr)                                                         \
         KLOG(SYSC, (vpe)->id() << ":" << (vpe)->name() << "@" << m3::fmt((vpe)->pe(), "X")  \
@@ -106,6 +137,7 @@ void SyscallHandler::init() {
     add_operation(m3::KIF::Syscall::FORWARD_MEM,    &SyscallHandler::forwardmem);
     add_operation(m3::KIF::Syscall::FORWARD_REPLY,  &SyscallHandler::forwardreply);
     add_operation(m3::KIF::Syscall::NOOP,           &SyscallHandler::noop);
+    add_operation(m3::KIF::Syscall::SYSC_STATS,     &SyscallHandler::syscstats);
 }
 
 void SyscallHandler::reply_msg(VPE *vpe, const m3::DTU::Message *msg, const void *reply, size_t size) {
@@ -128,12 +160,50 @@ void SyscallHandler::handle_message(VPE *vpe, const m3::DTU::Message *msg) {
     auto req = get_message<m3::KIF::DefaultRequest>(msg);
     m3::KIF::Syscall::Operation op = static_cast<m3::KIF::Syscall::Operation>(req->opcode);
 
-    if(static_cast<size_t>(op) < sizeof(_callbacks) / sizeof(_callbacks[0]))
+    if(static_cast<size_t>(op) < sizeof(_callbacks) / sizeof(_callbacks[0])) {
+        // note that the VPE might be gone afterwards; we only need the opcode
+        cycles_t start = DTU::get().get_time();
         _callbacks[op](vpe, msg);
+        add_time(op, DTU::get().get_time() - start);
+    }
     else
         reply_result(vpe, msg, m3::Errors::INV_ARGS);
 }
 
+void SyscallHandler::add_time(m3::KIF::Syscall::Operation op, cycles_t time) {
+    OpStats &st = _stats[op];
+    if(st.count == 0 || time < st.min)
+        st.min = time;
+    if(time > st.max)
+        st.max = time;
+    st.count++;
+    st.total += time;
+
+    int bucket = m3::getnextlog2(time) - 8;
+    if(bucket < 0)
+        bucket = 0;
+    else if(bucket >= static_cast<int>(m3::KIF::Syscall::STATS_BUCKETS))
+        bucket = m3::KIF::Syscall::STATS_BUCKETS - 1;
+    st.hist[bucket]++;
+}
+
+void SyscallHandler::print_stats() {
+    for(size_t i = 0; i < m3::KIF::Syscall::COUNT; ++i) {
+        const OpStats &st = _stats[i];
+        if(st.count == 0)
+            continue;
+
+        KLOG(SYSC_STATS, m3::fmt(sysc_names[i], "-", 14) << ": count=" << st.count
+            << ", avg=" << (st.total / st.count) << ", min=" << st.min << ", max=" << st.max
+            << ", vpewait=" << st.vpewait << ", srvwait=" << st.srvwait);
+
+        m3::OStringStream hist;
+        for(size_t b = 0; b < m3::KIF::Syscall::STATS_BUCKETS; ++b)
+            hist << " " << st.hist[b];
+        KLOG(SYSC_STATS, "  histogram:" << hist.str());
+    }
+}
+
 void SyscallHandler::pagefault(VPE *vpe, const m3::DTU::Message *msg) {
     EVENT_TRACER_Syscall_pagefault();
 
@@ -164,7 +234,7 @@ void SyscallHandler::pagefault(VPE *vpe, const m3::DTU::Message *msg) {
 
     // wait for pager
     VPE &tvpe = VPEManager::get().vpe(sgatecap->obj->rgate->vpe);
-    res = wait_for(": syscall::pagefault", tvpe, vpe, true);
+    res = wait_for(": syscall::pagefault", m3::KIF::Syscall::PAGEFAULT, tvpe, vpe, true);
 
     if(res == m3::Errors::NONE) {
         // re-enable the EP first, because the reply to the sent message below might otherwise
@@ -195,10 +265,11 @@ void SyscallHandler::createsrv(VPE *vpe, const m3::DTU::Message *msg) {
     capsel_t dst = req->dst_sel;
     capsel_t tvpe = req->vpe_sel;
     capsel_t rgate = req->rgate_sel;
+    m3::KIF::Syscall::SrvPolicy policy = static_cast<m3::KIF::Syscall::SrvPolicy>(req->policy);
     m3::String name(req->name, m3::Math::min(static_cast<size_t>(req->namelen), sizeof(req->name)));
 
     LOG_SYS(vpe, ": syscall::createsrv", "(dst=" << dst << ", vpe=" << tvpe
-        << ", rgate=" << rgate << ", name=" << name << ")");
+        << ", rgate=" << rgate << ", name=" << name << ", policy=" << policy << ")");
 
     if(!vpe->objcaps().unused(dst))
         SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid server selector");
@@ -213,10 +284,12 @@ void SyscallHandler::createsrv(VPE *vpe, const m3::DTU::Message *msg) {
 
     if(name.length() == 0)
         SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid server name");
-    if(ServiceList::get().find(name) != nullptr)
+    if(policy > m3::KIF::Syscall::SRV_PE_AFFINITY)
+        SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid service policy");
+    if(!ServiceList::get().can_add(name, policy))
         SYS_ERROR(vpe, msg, m3::Errors::EXISTS, "Service does already exist");
 
-    Service *s = ServiceList::get().add(*vpecap->obj, dst, name, rgatecap->obj);
+    Service *s = ServiceList::get().add(*vpecap->obj, dst, name, rgatecap->obj, policy);
     vpe->objcaps().set(dst, new ServCapability(&vpe->objcaps(), dst, s));
 
 #if defined(__host__)
@@ -544,7 +617,9 @@ void SyscallHandler::activate(VPE *vpe, const m3::DTU::Message *msg) {
                     ": waiting for rgate " << &sgateobj->rgate);
 
                 vpe->start_wait();
+                cycles_t start = DTU::get().get_time();
                 m3::ThreadManager::get().wait_for(reinterpret_cast<event_t>(&*sgateobj->rgate));
+                _stats[m3::KIF::Syscall::ACTIVATE].vpewait += DTU::get().get_time() - start;
                 vpe->stop_wait();
 
                 LOG_SYS(vpe, ": syscall::activate-cont",
@@ -590,13 +665,15 @@ void SyscallHandler::srvctrl(VPE *vpe, const m3::DTU::Message *msg) {
     auto req = get_message<m3::KIF::Syscall::SrvCtrl>(msg);
     capsel_t srv_sel = req->srv_sel;
     m3::KIF::Syscall::SrvOp op = static_cast<m3::KIF::Syscall::SrvOp>(req->op);
+    word_t arg = req->arg;
 
     static const char *opnames[] = {
-        "SHUTDOWN"
+        "SHUTDOWN", "ADD_SESS"
     };
 
     LOG_SYS(vpe, ": syscall::srvctrl", "(srv=" << srv_sel
-        << ", op=" << (static_cast<size_t>(op) < ARRAY_SIZE(opnames) ? opnames[op] : "??") << ")");
+        << ", op=" << (static_cast<size_t>(op) < ARRAY_SIZE(opnames) ? opnames[op] : "??")
+        << ", arg=" << arg << ")");
 
     auto srvcap = static_cast<ServCapability*>(vpe->objcaps().get(srv_sel, Capability::SERV));
     if(srvcap == nullptr)
@@ -611,6 +688,22 @@ void SyscallHandler::srvctrl(VPE *vpe, const m3::DTU::Message *msg) {
             ServiceList::get().send(srvcap->obj, &smsg, sizeof(smsg), false);
             break;
         }
+
+        case m3::KIF::Syscall::SCTRL_ADD_SESS: {
+            // the session has to live in the service's cap table, because we hand it out from there
+            if(vpe != &srvcap->obj->vpe())
+                SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Only the service can add sessions");
+
+            auto sesscap = static_cast<SessCapability*>(vpe->objcaps().get(arg, Capability::SESS));
+            if(sesscap == nullptr || &*sesscap->obj->srv != &*srvcap->obj)
+                SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid session cap");
+
+            srvcap->obj->add_session(arg);
+            break;
+        }
+
+        default:
+            SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid operation");
     }
 
     reply_result(vpe, msg, m3::Errors::NONE);
@@ -756,13 +849,34 @@ void SyscallHandler::opensess(VPE *vpe, const m3::DTU::Message *msg) {
     if(!vpe->objcaps().unused(dst))
         SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid cap");
 
-    Service *s = ServiceList::get().find(name);
+    Service *s = ServiceList::get().select(name, *vpe);
     if(!s)
         SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Unknown service");
 
     m3::Reference<Service> rsrv(s);
 
+    // if the service has pre-created sessions, hand out one of them and notify the service
+    // afterwards. since the service receives all further messages for the session via the same
+    // send queue, it sees the notification before anything else.
+    Capability *presess = s->take_session();
+    if(presess) {
+        auto sessobj = static_cast<SessCapability*>(presess)->obj;
+        vpe->objcaps().obtain(dst, presess);
+
+        LOG_SYS(vpe, ": syscall::opensess-fast", "(ident=" << m3::fmt(sessobj->ident, "#x") << ")");
+
+        m3::KIF::Service::Opened smsg;
+        smsg.opcode = m3::KIF::Service::OPENED;
+        smsg.sess = sessobj->ident;
+        smsg.arg = arg;
+        s->send(&smsg, sizeof(smsg), false);
+
+        reply_result(vpe, msg, m3::Errors::NONE);
+        return;
+    }
+
     vpe->start_wait();
+    cycles_t start = DTU::get().get_time();
     while(s->vpe().state() != VPE::RUNNING) {
         s->vpe().migrate_for(vpe);
         if(!s->vpe().resume()) {
@@ -770,12 +884,14 @@ void SyscallHandler::opensess(VPE *vpe, const m3::DTU::Message *msg) {
             SYS_ERROR(vpe, msg, m3::Errors::VPE_GONE, "VPE does no longer exist");
         }
     }
+    _stats[m3::KIF::Syscall::OPEN_SESS].vpewait += DTU::get().get_time() - start;
 
     m3::KIF::Service::Open smsg;
     smsg.opcode = m3::KIF::Service::OPEN;
     smsg.arg = arg;
 
-    const m3::DTU::Message *srvreply = s->send_receive(&smsg, sizeof(smsg), false);
+    const m3::DTU::Message *srvreply = send_receive(m3::KIF::Syscall::OPEN_SESS, *s,
+                                                    &smsg, sizeof(smsg));
     vpe->stop_wait();
 
     if(srvreply == nullptr)
@@ -911,7 +1027,10 @@ void SyscallHandler::exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, b
     // we can't be sure that the session will still exist when we receive the reply
     m3::Reference<Service> rsrv(sesscap->obj->srv);
 
+    m3::KIF::Syscall::Operation op = obtain ? m3::KIF::Syscall::OBTAIN : m3::KIF::Syscall::DELEGATE;
+
     vpe->start_wait();
+    cycles_t start = DTU::get().get_time();
     while(rsrv->vpe().state() != VPE::RUNNING) {
         rsrv->vpe().migrate_for(vpe);
         if(!rsrv->vpe().resume()) {
@@ -919,6 +1038,7 @@ void SyscallHandler::exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, b
             SYS_ERROR(vpe, msg, m3::Errors::VPE_GONE, "VPE does no longer exist");
         }
     }
+    _stats[op].vpewait += DTU::get().get_time() - start;
 
     m3::KIF::Service::Exchange smsg;
     smsg.opcode = obtain ? m3::KIF::Service::OBTAIN : m3::KIF::Service::DELEGATE;
@@ -926,7 +1046,7 @@ void SyscallHandler::exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, b
     smsg.data.caps = crd.count();
     memcpy(&smsg.data.args, &req->args, sizeof(req->args));
 
-    const m3::DTU::Message *srvreply = rsrv->send_receive(&smsg, sizeof(smsg), false);
+    const m3::DTU::Message *srvreply = send_receive(op, *rsrv, &smsg, sizeof(smsg));
     vpe->stop_wait();
 
     if(srvreply == nullptr)
@@ -953,8 +1073,18 @@ void SyscallHandler::exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, b
     reply_msg(vpe, msg, &kreply, sizeof(kreply));
 }
 
-m3::Errors::Code SyscallHandler::wait_for(const char *name, VPE &tvpe, VPE *cur, bool need_app) {
+const m3::DTU::Message *SyscallHandler::send_receive(m3::KIF::Syscall::Operation op, Service &srv,
+                                                     const void *msg, size_t size) {
+    cycles_t start = DTU::get().get_time();
+    const m3::DTU::Message *reply = srv.send_receive(msg, size, false);
+    _stats[op].srvwait += DTU::get().get_time() - start;
+    return reply;
+}
+
+m3::Errors::Code SyscallHandler::wait_for(const char *name, m3::KIF::Syscall::Operation op,
+                                          VPE &tvpe, VPE *cur, bool need_app) {
     m3::Errors::Code res = m3::Errors::NONE;
+    cycles_t start = DTU::get().get_time();
     bool same_group = cur->group() && cur->group() == tvpe.group();
     while(res == m3::Errors::NONE && tvpe.state() != VPE::RUNNING) {
         if(!same_group)
@@ -973,6 +1103,8 @@ m3::Errors::Code SyscallHandler::wait_for(const char *name, VPE &tvpe, VPE *cur,
             cur->stop_wait();
     }
 
+    _stats[op].vpewait += DTU::get().get_time() - start;
+
     LOG_SYS(cur, name, "-cont: VPE " << tvpe.id() << " ready");
     return res;
 }
@@ -1025,7 +1157,7 @@ void SyscallHandler::forwardmsg(VPE *vpe, const m3::DTU::Message *msg) {
         reply_result(vpe, msg, m3::Errors::UPCALL_REPLY);
     }
 
-    m3::Errors::Code res = wait_for(": syscall::forwardmsg", tvpe, vpe, true);
+    m3::Errors::Code res = wait_for(": syscall::forwardmsg", m3::KIF::Syscall::FORWARD_MSG, tvpe, vpe, true);
 
     if(res == m3::Errors::NONE) {
         // re-enable the EP first, because the reply to the sent message below might otherwise
@@ -1090,7 +1222,7 @@ void SyscallHandler::forwardmem(VPE *vpe, const m3::DTU::Message *msg) {
         reply_result(vpe, msg, m3::Errors::UPCALL_REPLY);
     }
 
-    m3::Errors::Code res = wait_for(": syscall::forwardmem", tvpe, vpe, false);
+    m3::Errors::Code res = wait_for(": syscall::forwardmem", m3::KIF::Syscall::FORWARD_MEM, tvpe, vpe, false);
 
     m3::KIF::Syscall::ForwardMemReply reply;
     reply.error = res;
@@ -1178,7 +1310,7 @@ void SyscallHandler::forwardreply(VPE *vpe, const m3::DTU::Message *msg) {
     // be running yet. otherwise, the app needs to be running
     // TODO this is just a stop-gap solution
     bool need_app = !Platform::pe(tvpe.pe()).has_mmu();
-    res = wait_for(": syscall::forwardreply", tvpe, vpe, need_app);
+    res = wait_for(": syscall::forwardreply", m3::KIF::Syscall::FORWARD_REPLY, tvpe, vpe, need_app);
     if(res == m3::Errors::NONE) {
         uint64_t sender = vpe->pe() | (vpe->id() << 8) |
                         (static_cast<uint64_t>(head.senderEp) << 32) |
@@ -1204,4 +1336,32 @@ void SyscallHandler::noop(VPE *vpe, const m3::DTU::Message *msg) {
     reply_result(vpe, msg, m3::Errors::NONE);
 }
 
+void SyscallHandler::syscstats(VPE *vpe, const m3::DTU::Message *msg) {
+    auto req = get_message<m3::KIF::Syscall::SyscStats>(msg);
+    size_t op = req->op;
+    bool reset = req->reset;
+
+    LOG_SYS(vpe, ": syscall::syscstats", "(op=" << op << ", reset=" << reset << ")");
+
+    if(op >= m3::KIF::Syscall::COUNT)
+        SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid operation");
+
+    OpStats &st = _stats[op];
+    m3::KIF::Syscall::SyscStatsReply reply;
+    reply.error = m3::Errors::NONE;
+    reply.count = st.count;
+    reply.total = st.total;
+    reply.min = st.min;
+    reply.max = st.max;
+    reply.vpewait = st.vpewait;
+    reply.srvwait = st.srvwait;
+    for(size_t i = 0; i < m3::KIF::Syscall::STATS_BUCKETS; ++i)
+        reply.hist[i] = st.hist[i];
+
+    if(reset)
+        memset(&st, 0, sizeof(st));
+
+    reply_msg(vpe, msg, &reply, sizeof(reply));
+}
+
 }
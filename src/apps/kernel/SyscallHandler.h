@@ -21,6 +21,7 @@
 
 namespace kernel {
 
+class Service;
 class VPE;
 
 class SyscallHandler {
@@ -28,6 +29,17 @@ class SyscallHandler {
 
     using handler_func = void (*)(VPE *vpe, const m3::DTU::Message *msg);
 
+    struct OpStats {
+        uint64_t count;
+        cycles_t total;
+        cycles_t min;
+        cycles_t max;
+        // the time spent waiting for other VPEs to be scheduled and for services to reply
+        cycles_t vpewait;
+        cycles_t srvwait;
+        uint64_t hist[m3::KIF::Syscall::STATS_BUCKETS];
+    };
+
 public:
     static const size_t SYSC_REP_COUNT = 2;
 
@@ -56,6 +68,8 @@ public:
 
     static void handle_message(VPE *vpe, const m3::DTU::Message *msg);
 
+    static void print_stats();
+
 private:
     static void pagefault(VPE *vpe, const m3::DTU::Message *msg);
     static void createsrv(VPE *vpe, const m3::DTU::Message *msg);
@@ -80,6 +94,7 @@ private:
     static void forwardmem(VPE *vpe, const m3::DTU::Message *msg);
     static void forwardreply(VPE *vpe, const m3::DTU::Message *msg);
     static void noop(VPE *vpe, const m3::DTU::Message *msg);
+    static void syscstats(VPE *vpe, const m3::DTU::Message *msg);
 
     static void add_operation(m3::KIF::Syscall::Operation op, handler_func func) {
         _callbacks[op] = func;
@@ -88,13 +103,18 @@ private:
     static void reply_msg(VPE *vpe, const m3::DTU::Message *msg, const void *reply, size_t size);
     static void reply_result(VPE *vpe, const m3::DTU::Message *msg, m3::Errors::Code code);
 
-    static m3::Errors::Code wait_for(const char *name, VPE &tvpe, VPE *cur, bool need_app);
+    static void add_time(m3::KIF::Syscall::Operation op, cycles_t time);
+    static m3::Errors::Code wait_for(const char *name, m3::KIF::Syscall::Operation op,
+                                     VPE &tvpe, VPE *cur, bool need_app);
+    static const m3::DTU::Message *send_receive(m3::KIF::Syscall::Operation op, Service &srv,
+                                                const void *msg, size_t size);
     static m3::Errors::Code do_exchange(VPE *v1, VPE *v2, const m3::KIF::CapRngDesc &c1,
                                         const m3::KIF::CapRngDesc &c2, bool obtain);
     static void exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, bool obtain);
 
     static ulong _vpes_per_ep[SYSC_REP_COUNT];
     static handler_func _callbacks[];
+    static OpStats _stats[];
 };
 
 }
@@ -19,11 +19,12 @@
 namespace kernel {
 
 VPEManager::~VPEManager() {
-    for(size_t i = 0; i < MAX_VPES; ++i) {
+    for(size_t i = 0; i < _size; ++i) {
         if(_vpes[i])
             delete _vpes[i];
     }
     delete[] _vpes;
+    delete[] _free_next;
 }
 
 }
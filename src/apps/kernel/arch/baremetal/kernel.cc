@@ -59,6 +59,7 @@ int main(int argc, char *argv[]) {
     EVENT_TRACE_FLUSH();
 
     KLOG(INFO, "Shutting down");
+    SyscallHandler::print_stats();
 
     VPEManager::destroy();
 
@@ -25,7 +25,7 @@
 namespace kernel {
 
 VPEManager::~VPEManager() {
-    for(size_t i = 0; i < MAX_VPES; ++i) {
+    for(size_t i = 0; i < _size; ++i) {
         if(_vpes[i]) {
             kill(_vpes[i]->pid(), SIGTERM);
             waitpid(_vpes[i]->pid(), nullptr, 0);
@@ -33,10 +33,11 @@ VPEManager::~VPEManager() {
         }
     }
     delete[] _vpes;
+    delete[] _free_next;
 }
 
 VPE *VPEManager::vpe_by_pid(int pid) {
-    for(vpeid_t i = 0; i < MAX_VPES; ++i) {
+    for(vpeid_t i = 0; i < _size; ++i) {
         if(_vpes[i] && _vpes[i]->pid() == pid)
             return _vpes[i];
     }
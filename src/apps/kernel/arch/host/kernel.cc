@@ -137,6 +137,7 @@ int main(int argc, char *argv[]) {
     m3::env()->workloop()->run();
 
     KLOG(INFO, "Shutting down");
+    SyscallHandler::print_stats();
     if(fsimg)
         copytofs(MainMemory::get(), fsimg);
     VPEManager::destroy();
@@ -23,18 +23,24 @@ namespace kernel {
 
 ServiceList ServiceList::_inst;
 
-Service::Service(VPE &vpe, capsel_t sel, const m3::String &name, const m3::Reference<RGateObject> &rgate)
+Service::Service(VPE &vpe, capsel_t sel, const m3::String &name,
+                 const m3::Reference<RGateObject> &rgate, m3::KIF::Syscall::SrvPolicy policy)
     : m3::SListItem(),
       RefCounted(),
       _squeue(vpe),
       _sel(sel),
       _name(name),
+      _policy(policy),
+      _ticket(),
       _sgate(vpe, rgate->ep, 0),
       _rgate(rgate) {
     vpe.add_service();
 }
 
 Service::~Service() {
+    while(_sessions.length() > 0)
+        delete _sessions.remove_first();
+
     _sgate.vpe().rem_service();
     // we have allocated the selector and stored it in our cap-table on creation; undo that
     ServiceList::get().remove(this);
@@ -44,6 +50,20 @@ int Service::pending() const {
     return _squeue.inflight() + _squeue.pending();
 }
 
+Capability *Service::take_session() {
+    while(_sessions.length() > 0) {
+        SessSlot *slot = _sessions.remove_first();
+        capsel_t sel = slot->sel;
+        delete slot;
+
+        // the service might have revoked the session in the meantime
+        Capability *cap = vpe().objcaps().get(sel, Capability::SESS);
+        if(cap)
+            return cap;
+    }
+    return nullptr;
+}
+
 void Service::send(const void *msg, size_t size, bool free) {
     if(!_rgate->activated())
         return;
@@ -62,4 +82,61 @@ const m3::DTU::Message *Service::send_receive(const void *msg, size_t size, bool
     return reinterpret_cast<const m3::DTU::Message*>(m3::ThreadManager::get().get_current_msg());
 }
 
+bool ServiceList::can_add(const m3::String &name, m3::KIF::Syscall::SrvPolicy policy) {
+    for(auto &s : _list) {
+        if(s.name() == name) {
+            if(policy == m3::KIF::Syscall::SRV_EXCL || s.policy() != policy)
+                return false;
+        }
+    }
+    return true;
+}
+
+Service *ServiceList::select(const m3::String &name, const VPE &client) {
+    Service *first = find(name);
+    if(!first || first->policy() == m3::KIF::Syscall::SRV_EXCL)
+        return first;
+
+    Service *res = first;
+    size_t count = 0;
+    for(auto &s : _list) {
+        if(s.name() != name)
+            continue;
+
+        switch(first->policy()) {
+            case m3::KIF::Syscall::SRV_ROUNDROBIN:
+                // the instance that has been used least recently is next in turn
+                if(s._ticket < res->_ticket)
+                    res = &s;
+                break;
+
+            case m3::KIF::Syscall::SRV_LEAST_PENDING:
+                if(s.pending() < res->pending())
+                    res = &s;
+                break;
+
+            case m3::KIF::Syscall::SRV_PE_AFFINITY:
+                if(s.vpe().pe() == client.pe())
+                    return &s;
+                break;
+
+            default:
+                break;
+        }
+        count++;
+    }
+
+    if(first->policy() == m3::KIF::Syscall::SRV_PE_AFFINITY) {
+        // no instance on the client's PE; map each PE to a fixed instance
+        size_t idx = client.pe() % count;
+        for(auto &s : _list) {
+            if(s.name() == name && idx-- == 0)
+                return &s;
+        }
+    }
+
+    res->_ticket = ++_ticket;
+    return res;
+}
+
 }
@@ -18,6 +18,7 @@
 
 #include <base/Common.h>
 #include <base/col/SList.h>
+#include <base/KIF.h>
 #include <base/util/String.h>
 #include <base/util/Reference.h>
 
@@ -27,12 +28,23 @@
 
 namespace kernel {
 
+class Capability;
 class VPE;
 class RGateObject;
 
 class Service : public SlabObject<Service>, public m3::SListItem, public m3::RefCounted {
+    friend class ServiceList;
+
+    struct SessSlot : public SlabObject<SessSlot>, public m3::SListItem {
+        explicit SessSlot(capsel_t _sel) : sel(_sel) {
+        }
+
+        capsel_t sel;
+    };
+
 public:
-    explicit Service(VPE &vpe, capsel_t sel, const m3::String &name, const m3::Reference<RGateObject> &rgate);
+    explicit Service(VPE &vpe, capsel_t sel, const m3::String &name,
+                     const m3::Reference<RGateObject> &rgate, m3::KIF::Syscall::SrvPolicy policy);
     ~Service();
 
     VPE &vpe() const {
@@ -47,9 +59,26 @@ public:
     const m3::Reference<RGateObject> &rgate() const {
         return _rgate;
     }
+    m3::KIF::Syscall::SrvPolicy policy() const {
+        return _policy;
+    }
 
     int pending() const;
 
+    /**
+     * Adds the pre-created session with given selector (in the service's cap table) to the pool of
+     * sessions that are handed out to clients without asking the service.
+     */
+    void add_session(capsel_t sel) {
+        _sessions.append(new SessSlot(sel));
+    }
+    /**
+     * Takes the next session from the pool.
+     *
+     * @return the session capability or nullptr if the pool is empty
+     */
+    Capability *take_session();
+
     void send(const void *msg, size_t size, bool free);
     const m3::DTU::Message *send_receive(const void *msg, size_t size, bool free);
     void abort() {
@@ -60,12 +89,16 @@ private:
     SendQueue _squeue;
     capsel_t _sel;
     m3::String _name;
+    m3::KIF::Syscall::SrvPolicy _policy;
+    // the ticket of the last session that has been assigned to this instance (for round-robin)
+    uint64_t _ticket;
     SendGate _sgate;
     m3::Reference<RGateObject> _rgate;
+    m3::SList<SessSlot> _sessions;
 };
 
 class ServiceList {
-    explicit ServiceList() : _list() {
+    explicit ServiceList() : _list(), _ticket() {
     }
 
 public:
@@ -84,8 +117,9 @@ public:
         return _list.end();
     }
 
-    Service *add(VPE &vpe, capsel_t sel, const m3::String &name, const m3::Reference<RGateObject> &rgate) {
-        Service *inst = new Service(vpe, sel, name, rgate);
+    Service *add(VPE &vpe, capsel_t sel, const m3::String &name,
+                 const m3::Reference<RGateObject> &rgate, m3::KIF::Syscall::SrvPolicy policy) {
+        Service *inst = new Service(vpe, sel, name, rgate, policy);
         // prepend to the list to shutdown services in the opposite order
         _list.insert(nullptr, inst);
         return inst;
@@ -101,6 +135,23 @@ public:
         return nullptr;
     }
 
+    /**
+     * Checks whether another instance of a service with given name and policy can be registered.
+     * This is the case if there is no instance yet or if all instances share <name> with the same
+     * policy.
+     */
+    bool can_add(const m3::String &name, m3::KIF::Syscall::SrvPolicy policy);
+
+    /**
+     * Selects the instance of the service with given name that should receive the next session
+     * of <client>, according to the policy the instances have been registered with.
+     *
+     * @param name the service name
+     * @param client the VPE that wants to open a session
+     * @return the instance or nullptr if there is none
+     */
+    Service *select(const m3::String &name, const VPE &client);
+
     void send(m3::Reference<Service> serv, const void *msg, size_t size, bool free) {
         serv->send(msg, size, free);
     }
@@ -111,6 +162,7 @@ private:
     }
 
     m3::SList<Service> _list;
+    uint64_t _ticket;
     static ServiceList _inst;
 };
 
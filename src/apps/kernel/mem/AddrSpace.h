@@ -20,12 +20,13 @@
 #include <base/DTU.h>
 
 #include "mem/MainMemory.h"
+#include "mem/SlabCache.h"
 #include "pes/VPEDesc.h"
 #include "Platform.h"
 
 namespace kernel {
 
-class AddrSpace {
+class AddrSpace : public SlabObject<AddrSpace> {
 public:
     typedef uint64_t mmu_pte_t;
 
@@ -44,7 +44,7 @@ class VPE : public m3::SListItem, public SlabObject<VPE>, public m3::RefCounted
     friend class VPEGroup;
     friend class VPEManager;
 
-    struct ServName : public m3::SListItem {
+    struct ServName : public SlabObject<ServName>, public m3::SListItem {
         explicit ServName(const m3::String &_name) : name(_name) {
         }
         m3::String name;
@@ -15,6 +15,7 @@
  */
 
 #include <base/log/Kernel.h>
+#include <base/util/Math.h>
 #include <base/Panic.h>
 
 #include "pes/PEManager.h"
@@ -29,7 +30,11 @@ VPEManager *VPEManager::_inst;
 
 VPEManager::VPEManager()
     : _next_id(0),
-      _vpes(new VPE*[MAX_VPES]()),
+      _free_first(MAX_VPES),
+      _free_last(MAX_VPES),
+      _free_next(new vpeid_t[INIT_VPES]),
+      _size(INIT_VPES),
+      _vpes(new VPE*[INIT_VPES]()),
       _count(),
       _daemons(),
       _pending() {
@@ -140,20 +145,49 @@ void VPEManager::shutdown() {
     }
 }
 
+bool VPEManager::grow() {
+    if(_size == MAX_VPES)
+        return false;
+
+    size_t nsize = m3::Math::min(_size * 2, MAX_VPES);
+    VPE **nvpes = new VPE*[nsize]();
+    vpeid_t *nfree = new vpeid_t[nsize];
+    memcpy(nvpes, _vpes, _size * sizeof(VPE*));
+    memcpy(nfree, _free_next, _size * sizeof(vpeid_t));
+    delete[] _vpes;
+    delete[] _free_next;
+
+    _vpes = nvpes;
+    _free_next = nfree;
+    _size = nsize;
+    return true;
+}
+
 vpeid_t VPEManager::get_id() {
-    vpeid_t id = _next_id;
-    for(; id < MAX_VPES && _vpes[id] != nullptr; ++id)
-        ;
-    if(id == MAX_VPES) {
-        for(id = 0; id < MAX_VPES && _vpes[id] != nullptr; ++id)
-            ;
+    if(_next_id == _size && _free_first == MAX_VPES) {
+        if(!grow())
+            return MAX_VPES;
     }
-    if(id == MAX_VPES)
-        return MAX_VPES;
-    _next_id = id + 1;
+
+    if(_next_id < _size)
+        return _next_id++;
+
+    vpeid_t id = _free_first;
+    _free_first = _free_next[id];
+    if(_free_first == MAX_VPES)
+        _free_last = MAX_VPES;
     return id;
 }
 
+void VPEManager::put_id(vpeid_t id) {
+    _free_next[id] = MAX_VPES;
+    if(_free_last != MAX_VPES)
+        _free_next[_free_last] = id;
+    else
+        _free_first = id;
+    _free_last = id;
+}
+
 VPE *VPEManager::create(m3::String &&name, const m3::PEDesc &pe, epid_t sep, epid_t rep,
                         capsel_t sgate, uint flags, VPEGroup *group) {
     uint vflags = 0;
@@ -197,6 +231,7 @@ void VPEManager::remove(VPE *vpe) {
 
     // do that afterwards, because some actions in the destructor might try to get the VPE
     _vpes[vpe->id()] = nullptr;
+    put_id(vpe->id());
 
     if(vpe->_flags & VPE::F_IDLE)
         return;
@@ -27,7 +27,7 @@ class VPEManager {
     friend class VPE;
     friend class ContextSwitcher;
 
-    struct Pending : public m3::SListItem {
+    struct Pending : public SlabObject<Pending>, public m3::SListItem {
         explicit Pending(VPE *_vpe) : vpe(_vpe) {
         }
 
@@ -35,7 +35,10 @@ class VPEManager {
     };
 
 public:
+    // the VPE id space is limited by the DTU; MAX_VPES is used as the kernel's id
     static const size_t MAX_VPES    = 1024;
+    // the initial size of the VPE table, which is doubled on demand up to MAX_VPES
+    static const size_t INIT_VPES   = 64;
 
     static void create() {
         _inst = new VPEManager();
@@ -71,7 +74,7 @@ public:
     }
 
     bool exists(vpeid_t id) {
-        return id < MAX_VPES && _vpes[id];
+        return id < _size && _vpes[id];
     }
 
     VPE &vpe(vpeid_t id) {
@@ -89,11 +92,19 @@ public:
 
 private:
     vpeid_t get_id();
+    void put_id(vpeid_t id);
+    bool grow();
 
     void add(VPE *vpe);
     void remove(VPE *vpe);
 
+    // ids that have never been used so far are handed out first, followed by the free list, which
+    // contains the ids of destroyed VPEs in FIFO order to delay the reuse of ids
     vpeid_t _next_id;
+    vpeid_t _free_first;
+    vpeid_t _free_last;
+    vpeid_t *_free_next;
+    size_t _size;
     VPE **_vpes;
     size_t _count;
     size_t _daemons;
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#include <base/util/Math.h>
+
+#include "DentryCache.h"
+
+using namespace m3;
+
+DentryCache::DentryCache(size_t size)
+    : _size(Math::max<size_t>(size, 1)),
+      _entries(new Entry[_size]),
+      _buckets(new Entry*[_size]()),
+      _lru(),
+      _generation(),
+      _stats() {
+    for(size_t i = 0; i < _size; ++i)
+        _lru.append(_entries + i);
+}
+
+DentryCache::~DentryCache() {
+    delete[] _buckets;
+    delete[] _entries;
+}
+
+DentryCache::Entry *DentryCache::get(inodeno_t dir, uint32_t hash, const char *name, size_t namelen) {
+    for(Entry *e = *bucket(hash); e; e = e->hnext) {
+        if(e->matches(dir, hash, name, namelen))
+            return e;
+    }
+    return nullptr;
+}
+
+void DentryCache::unlink(Entry *e) {
+    Entry **p = bucket(e->hash);
+    while(*p != e)
+        p = &(*p)->hnext;
+    *p = e->hnext;
+    e->hnext = nullptr;
+    e->dir = INVALID_INO;
+}
+
+bool DentryCache::find(inodeno_t dir, const char *name, size_t namelen, inodeno_t *ino) {
+    Entry *e = get(dir, hash(dir, name, namelen), name, namelen);
+    if(!e) {
+        _stats.misses++;
+        return false;
+    }
+
+    if(e->ino == INVALID_INO)
+        _stats.negative_hits++;
+    else
+        _stats.hits++;
+    _lru.moveToEnd(e);
+    *ino = e->ino;
+    return true;
+}
+
+void DentryCache::insert(inodeno_t dir, const char *name, size_t namelen, inodeno_t ino) {
+    _generation++;
+    put(dir, name, namelen, ino);
+}
+
+void DentryCache::insert_lookup(size_t gen, inodeno_t dir, const char *name, size_t namelen,
+                                inodeno_t ino) {
+    if(gen != _generation) {
+        _stats.stale++;
+        return;
+    }
+    put(dir, name, namelen, ino);
+}
+
+void DentryCache::put(inodeno_t dir, const char *name, size_t namelen, inodeno_t ino) {
+    if(namelen > MAX_NAME_LEN)
+        return;
+
+    uint32_t h = hash(dir, name, namelen);
+    Entry *e = get(dir, h, name, namelen);
+    if(!e) {
+        // reuse an unused entry or the least recently used one
+        e = &*_lru.begin();
+        if(e->dir != INVALID_INO) {
+            _stats.evictions++;
+            unlink(e);
+        }
+
+        e->dir = dir;
+        e->hash = h;
+        e->namelen = namelen;
+        memcpy(e->name, name, namelen);
+        Entry **b = bucket(h);
+        e->hnext = *b;
+        *b = e;
+    }
+
+    e->ino = ino;
+    _lru.moveToEnd(e);
+}
+
+void DentryCache::remove_dir(inodeno_t dir) {
+    _generation++;
+    for(size_t i = 0; i < _size; ++i) {
+        Entry *e = _entries + i;
+        if(e->dir == dir) {
+            unlink(e);
+            _lru.remove(e);
+            _lru.prepend(e);
+        }
+    }
+}
+
+void DentryCache::print_stats(OStream &os) const {
+    os << "DentryCache: capacity=" << _size << " entries\n";
+    os << "  hits=" << _stats.hits << " negative_hits=" << _stats.negative_hits
+       << " misses=" << _stats.misses << " evictions=" << _stats.evictions
+       << " stale=" << _stats.stale << "\n";
+}
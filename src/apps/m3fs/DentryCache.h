@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include <base/col/DList.h>
+#include <base/stream/OStream.h>
+
+#include <fs/internal.h>
+
+/**
+ * Caches the results of directory lookups, i.e., maps the name in a directory to the inode,
+ * including lookups that did not find anything. Thereby, the path resolution does not need to
+ * walk through the directory blocks again for recently used paths. The entries are replaced in
+ * LRU order. Everyone that changes directory entries has to update the cache accordingly.
+ *
+ * Since lookups might block while loading directory blocks, their result might be outdated when
+ * the lookup is finished. Thus, changes increase the generation and the result of a lookup is only
+ * cached if the generation did not change in the meantime.
+ */
+class DentryCache {
+    static const size_t MAX_NAME_LEN    = 52;
+
+    struct Entry : public m3::DListItem {
+        Entry()
+            : m3::DListItem(),
+              hnext(),
+              dir(m3::INVALID_INO),
+              ino(m3::INVALID_INO),
+              hash(),
+              namelen(),
+              name() {
+        }
+
+        bool matches(m3::inodeno_t d, uint32_t h, const char *n, size_t len) const {
+            return dir == d && hash == h && namelen == len && strncmp(name, n, len) == 0;
+        }
+
+        // the next one in the same hash bucket
+        Entry *hnext;
+        // INVALID_INO, if the entry is unused
+        m3::inodeno_t dir;
+        // INVALID_INO, if the name does not exist
+        m3::inodeno_t ino;
+        uint32_t hash;
+        size_t namelen;
+        char name[MAX_NAME_LEN];
+    };
+
+public:
+    static const size_t DEF_SIZE        = 1024;
+
+    struct Stats {
+        size_t hits;
+        size_t negative_hits;
+        size_t misses;
+        size_t evictions;
+        size_t stale;
+    };
+
+    explicit DentryCache(size_t size = DEF_SIZE);
+    ~DentryCache();
+
+    /**
+     * Looks up <name> in the directory <dir>.
+     *
+     * @return true if the entry is cached. In this case, <ino> is set to the inode number or to
+     *  INVALID_INO if the name does not exist.
+     */
+    bool find(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t *ino);
+    /**
+     * @return the current generation, which is increased by insert() and remove_dir()
+     */
+    size_t generation() const {
+        return _generation;
+    }
+    /**
+     * Remembers that <name> in <dir> refers to <ino>, which is INVALID_INO if it does not exist,
+     * after the entry has been changed.
+     */
+    void insert(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t ino);
+    /**
+     * Remembers the result of a lookup that has been started in generation <gen>. If the
+     * generation changed meanwhile, the result is dropped.
+     */
+    void insert_lookup(size_t gen, m3::inodeno_t dir, const char *name, size_t namelen,
+                       m3::inodeno_t ino);
+    /**
+     * Forgets all entries in the directory <dir>.
+     */
+    void remove_dir(m3::inodeno_t dir);
+
+    const Stats &stats() const {
+        return _stats;
+    }
+    void print_stats(m3::OStream &os) const;
+
+private:
+    static uint32_t hash(m3::inodeno_t dir, const char *name, size_t namelen) {
+        return m3::dir_hash(name, namelen) ^ (dir * 0x9E3779B1u);
+    }
+    Entry **bucket(uint32_t hash) {
+        return &_buckets[hash % _size];
+    }
+    Entry *get(m3::inodeno_t dir, uint32_t hash, const char *name, size_t namelen);
+    void put(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t ino);
+    void unlink(Entry *e);
+
+    size_t _size;
+    Entry *_entries;
+    Entry **_buckets;
+    // unused entries first, then the least recently used ones
+    m3::DList<Entry> _lru;
+    size_t _generation;
+    Stats _stats;
+};
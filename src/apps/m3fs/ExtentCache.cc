@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#include <base/util/Math.h>
+
+#include "data/INodes.h"
+#include "ExtentCache.h"
+#include "FSHandle.h"
+
+using namespace m3;
+
+ExtentCache::ExtentCache(size_t size)
+    : _size(Math::max<size_t>(size, 1)),
+      _entries(new Entry[_size]),
+      _tree(),
+      _lru(),
+      _stats() {
+    for(size_t i = 0; i < _size; ++i)
+        _lru.append(_entries + i);
+}
+
+ExtentCache::~ExtentCache() {
+    delete[] _entries;
+}
+
+void ExtentCache::load(Request &r, INode *inode, Entry *e) {
+    size_t n = inode->extents;
+    if(n > e->capacity) {
+        size_t ncap = Math::max(n, e->capacity * 2);
+        uint32_t *nends = new uint32_t[ncap];
+        memcpy(nends, e->ends, e->count * sizeof(uint32_t));
+        delete[] e->ends;
+        e->ends = nends;
+        e->capacity = ncap;
+    }
+
+    // the last extent might have grown and new ones might have been added
+    size_t i = Math::min(e->count, n);
+    if(i > 0)
+        i--;
+    _stats.loaded += n - i;
+
+    size_t org_used = r.used_meta();
+    Extent *indir = nullptr;
+    for(; i < n; ++i) {
+        Extent *ext = INodes::get_extent(r, inode, i, &indir, false);
+        if(!ext)
+            break;
+        e->ends[i] = (i > 0 ? e->ends[i - 1] : 0) + ext->length;
+    }
+    e->count = i;
+    r.pop_meta(r.used_meta() - org_used);
+}
+
+ExtentCache::Entry *ExtentCache::get(Request &r, INode *inode) {
+    Entry *e = _tree.find(inode->inode);
+    if(!e) {
+        // reuse an unused entry or the least recently used one that is not being loaded
+        for(auto &c : _lru) {
+            if(c.pins == 0) {
+                e = &c;
+                break;
+            }
+        }
+        if(!e) {
+            _stats.busy++;
+            return nullptr;
+        }
+
+        if(e->key() != INVALID_INO)
+            _tree.remove(e);
+        e->key(inode->inode);
+        e->count = 0;
+        _tree.insert(e);
+        _stats.builds++;
+    }
+
+    // loading might block, so that others should take a different entry meanwhile
+    _lru.moveToEnd(e);
+    e->pins++;
+    load(r, inode, e);
+    e->pins--;
+
+    // truncate might have invalidated it meanwhile
+    if(e->key() != inode->inode)
+        return nullptr;
+    return e;
+}
+
+bool ExtentCache::seek(Request &r, INode *inode, size_t &off, size_t &extent, size_t &extoff,
+                       size_t *pos) {
+    size_t blocksize = r.hdl().sb().blocksize;
+    Entry *e = get(r, inode);
+    if(!e)
+        return false;
+    _stats.lookups++;
+
+    // find the first extent that ends behind <off>
+    size_t lo = 0, hi = e->count;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(static_cast<size_t>(e->ends[mid]) * blocksize > off)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    *pos = lo > 0 ? static_cast<size_t>(e->ends[lo - 1]) * blocksize : 0;
+    off -= *pos;
+    extent = lo;
+    extoff = off;
+    return true;
+}
+
+void ExtentCache::invalidate(inodeno_t ino) {
+    Entry *e = _tree.find(ino);
+    if(e) {
+        _tree.remove(e);
+        e->key(INVALID_INO);
+        e->count = 0;
+        _lru.remove(e);
+        _lru.prepend(e);
+    }
+}
+
+void ExtentCache::print_stats(OStream &os) const {
+    os << "ExtentCache: capacity=" << _size << " inodes\n";
+    os << "  lookups=" << _stats.lookups << " builds=" << _stats.builds
+       << " loaded=" << _stats.loaded << " extents busy=" << _stats.busy << "\n";
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include <base/col/DList.h>
+#include <base/col/Treap.h>
+#include <base/stream/OStream.h>
+
+#include <fs/internal.h>
+
+class Request;
+
+/**
+ * Translates file offsets into extents for inodes with many extents. The extents can only be
+ * found by walking over them, because each one has a different length. Thus, this cache stores the
+ * number of blocks up to the end of each extent for the recently used inodes, so that the extent
+ * is found by a binary search instead. Since extents are only added or resized at the end, the
+ * last indexed extent is read again on each lookup; truncate() has to invalidate the index.
+ * Loading extents might block. Meanwhile, the entry is pinned, so that other threads do not reuse
+ * it for a different inode.
+ */
+class ExtentCache {
+    struct Entry : public m3::TreapNode<Entry, m3::inodeno_t>, public m3::DListItem {
+        Entry()
+            : m3::TreapNode<Entry, m3::inodeno_t>(m3::INVALID_INO),
+              m3::DListItem(),
+              count(),
+              capacity(),
+              pins(),
+              ends() {
+        }
+        ~Entry() {
+            delete[] ends;
+        }
+
+        // the number of indexed extents
+        size_t count;
+        size_t capacity;
+        // the number of threads that are loading extents into it
+        size_t pins;
+        // ends[i] is the number of blocks in the extents 0..i
+        uint32_t *ends;
+    };
+
+public:
+    // inodes with fewer extents are searched linearly
+    static const size_t MIN_EXTENTS     = 16;
+    static const size_t DEF_SIZE        = 32;
+
+    struct Stats {
+        size_t lookups;
+        size_t builds;
+        size_t loaded;
+        size_t busy;
+    };
+
+    explicit ExtentCache(size_t size = DEF_SIZE);
+    ~ExtentCache();
+
+    /**
+     * Determines the extent that contains <off>, like INodes::seek with M3FS_SEEK_SET, and stores
+     * the file position of the extent in <pos>.
+     *
+     * @return false if no index is available, because all entries are in use
+     */
+    bool seek(Request &r, m3::INode *inode, size_t &off, size_t &extent, size_t &extoff,
+              size_t *pos);
+
+    /**
+     * Drops the index of inode <ino>
+     */
+    void invalidate(m3::inodeno_t ino);
+
+    const Stats &stats() const {
+        return _stats;
+    }
+    void print_stats(m3::OStream &os) const;
+
+private:
+    Entry *get(Request &r, m3::INode *inode);
+    void load(Request &r, m3::INode *inode, Entry *e);
+
+    size_t _size;
+    Entry *_entries;
+    m3::Treap<Entry> _tree;
+    // unused entries first, then the least recently used ones
+    m3::DList<Entry> _lru;
+    Stats _stats;
+};
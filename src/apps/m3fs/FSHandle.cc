@@ -35,21 +35,29 @@ bool FSHandle::load_superblock(Backend *backend, SuperBlock *sb, bool clear) {
     SLOG(FS, "  free_blocks=" << sb->free_blocks);
     SLOG(FS, "  first_free_inode=" << sb->first_free_inode);
     SLOG(FS, "  first_free_block=" << sb->first_free_block);
+    SLOG(FS, "  features=" << fmt(sb->features, "#x"));
     if(sb->checksum != sb->get_checksum())
         PANIC("Superblock checksum is invalid. Terminating.");
     return clear;
 }
 
-FSHandle::FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load)
+FSHandle::FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load,
+                   size_t fbsize, size_t mbsize)
     : _backend(backend),
       _clear(load_superblock(backend, &_sb, clear)),
       _revoke_first(revoke_first),
       _extend(extend),
-      _filebuffer(_sb.blocksize, backend, max_load),
-      _metabuffer(_sb.blocksize, backend),
+      _filebuffer(_sb.blocksize, backend, max_load, fbsize),
+      _prefetcher(_filebuffer),
+      _metabuffer(_sb.blocksize, backend, mbsize),
+      _dentries(),
+      _extents(),
       _blocks("Blocks", _sb.first_blockbm_block(), &_sb.first_free_block, &_sb.free_blocks,
               _sb.total_blocks, _sb.blockbm_blocks()),
       _inodes("INodes", _sb.first_inodebm_block(), &_sb.first_free_inode, &_sb.free_inodes,
               _sb.total_inodes, _sb.inodebm_blocks()),
       _files(*this) {
+    Request r(*this);
+    _blocks.load(r);
+    _inodes.load(r);
 }
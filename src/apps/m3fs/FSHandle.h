@@ -22,13 +22,17 @@
 
 #include "FileBuffer.h"
 #include "MetaBuffer.h"
+#include "DentryCache.h"
+#include "ExtentCache.h"
+#include "Prefetcher.h"
 #include "backend/Backend.h"
 #include "data/Allocator.h"
 #include "sess/OpenFiles.h"
 
 class FSHandle {
 public:
-    explicit FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load);
+    explicit FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load,
+                      size_t fbsize, size_t mbsize);
 
     m3::SuperBlock &sb() {
         return _sb;
@@ -42,6 +46,15 @@ public:
     MetaBuffer &metabuffer() {
         return _metabuffer;
     }
+    Prefetcher &prefetcher() {
+        return _prefetcher;
+    }
+    DentryCache &dentries() {
+        return _dentries;
+    }
+    ExtentCache &extents() {
+        return _extents;
+    }
     Allocator &inodes() {
         return _inodes;
     }
@@ -80,7 +93,10 @@ private:
     size_t _extend;
     m3::SuperBlock _sb;
     FileBuffer _filebuffer;
+    Prefetcher _prefetcher;
     MetaBuffer _metabuffer;
+    DentryCache _dentries;
+    ExtentCache _extents;
     Allocator _blocks;
     Allocator _inodes;
     OpenFiles _files;
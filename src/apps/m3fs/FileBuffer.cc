@@ -19,22 +19,66 @@
 
 #include <fs/internal.h>
 
+#include <string.h>
+
 using namespace m3;
 
 FileBufferHead::FileBufferHead(blockno_t bno, size_t size, size_t blocksize)
     : BufferHead(bno, size),
-      _data(MemGate::create_global(size * blocksize + Buffer::PRDT_SIZE, MemGate::RWX)) {
+      _data(MemGate::create_global(size * blocksize + Buffer::PRDT_SIZE, MemGate::RWX)),
+      _frequent(false),
+      _dirty_bits(new word_t[(size + WORD_BITS - 1) / WORD_BITS]),
+      _pending_bits(new word_t[(size + WORD_BITS - 1) / WORD_BITS]),
+      _ndirty(),
+      _wseq() {
     _extents.append(new InodeExt(bno, size));
+    clear_bits();
+}
+
+FileBufferHead::~FileBufferHead() {
+    delete[] _dirty_bits;
+    delete[] _pending_bits;
+}
+
+size_t FileBufferHead::mark(word_t *bits, size_t off, size_t count, bool set) {
+    size_t changed = 0;
+    for(size_t i = off; i < off + count; ++i) {
+        word_t bit = static_cast<word_t>(1) << (i % WORD_BITS);
+        if(set != ((bits[i / WORD_BITS] & bit) != 0))
+            changed++;
+        if(set)
+            bits[i / WORD_BITS] |= bit;
+        else
+            bits[i / WORD_BITS] &= ~bit;
+    }
+    return changed;
+}
+
+void FileBufferHead::clear_bits() {
+    size_t words = (_size + WORD_BITS - 1) / WORD_BITS;
+    memset(_dirty_bits, 0, words * sizeof(word_t));
+    memset(_pending_bits, 0, words * sizeof(word_t));
+    _ndirty = 0;
 }
 
-FileBuffer::FileBuffer(size_t blocksize, Backend *backend, size_t max_load)
+FileBuffer::FileBuffer(size_t blocksize, Backend *backend, size_t max_load, size_t size)
     : Buffer(blocksize, backend),
       _size(),
-      _max_load(max_load) {
+      _recent_size(),
+      _ghost_size(),
+      _dirty_blocks(),
+      _capacity(Math::max(size, MIN_SIZE)),
+      _max_load(max_load),
+      _recent(),
+      _ghosts(),
+      _ghost_tree(),
+      _recent_stats(),
+      _frequent_stats(),
+      _ghost_stats() {
 }
 
 size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perms, size_t accessed,
-                              bool load, bool dirty) {
+                              bool load, bool dirty, File::Advice advice) {
     while(true) {
         FileBufferHead *b = FileBuffer::get(bno);
         if(b) {
@@ -46,8 +90,16 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
             }
             else {
                 // lock?
-                lru.remove(b);
-                lru.append(b);
+                // hits in the recent list are usually correlated (e.g., the next part of a
+                // sequential read) and thus don't make the chunk frequently used.
+                // blocks that are not reused stay where they are to be evicted first
+                if(b->_frequent) {
+                    _frequent_stats.hits++;
+                    if(advice != File::NOREUSE)
+                        lru.moveToEnd(b);
+                }
+                else
+                    _recent_stats.hits++;
                 SLOG(FS, "FileFuffer: Found cached blocks <"
                     << b->key() << "," << b->_size << ">, for block " << bno);
                 size_t len       = Math::min(size, static_cast<size_t>(b->_size - (bno - b->key())));
@@ -56,7 +108,10 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
 
                 if(res != Errors::NONE)
                     return 0;
-                b->dirty |= dirty;
+                if(dirty) {
+                    FileBufferHead::mark(b->_pending_bits, bno - b->key(), len, true);
+                    b->dirty = true;
+                }
                 return len * _blocksize;
             }
         }
@@ -64,45 +119,66 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
             break;
     }
 
+    // chunks that have been evicted from the recent list recently are used frequently
+    bool frequent = false;
+    FileBufferGhost *ghost = _ghost_tree.find(bno);
+    if(ghost) {
+        _ghost_stats.hits++;
+        _ghost_tree.remove(ghost);
+        _ghosts.remove(ghost);
+        _ghost_size -= ghost->_size;
+        delete ghost;
+        frequent = advice != File::NOREUSE;
+    }
+    else
+        _ghost_stats.misses++;
+
     // load chunk into memory
-    // size_t max_size = Math::min((size_t)FILE_BUFFER_SIZE, _max_load);
-    size_t max_size = Math::min(FILE_BUFFER_SIZE, static_cast<size_t>(1) << accessed);
-    // size_t max_size = Math::min((size_t)FILE_BUFFER_SIZE, _max_load * accessed);
-    size_t load_size = Math::min(load ? max_size : FILE_BUFFER_SIZE, size);
+    // size_t max_size = Math::min(_capacity, _max_load);
+    size_t max_size = Math::min(_capacity, static_cast<size_t>(1) << accessed);
+    // size_t max_size = Math::min(_capacity, _max_load * accessed);
+    // with advice, we don't need to guess: scans load large chunks right away, random accesses
+    // only the requested block
+    if(advice == File::SEQUENTIAL || advice == File::NOREUSE)
+        max_size = Math::max(max_size, Math::min(_capacity, _max_load));
+    else if(advice == File::RANDOM)
+        max_size = 1;
+    size_t load_size = Math::min(load ? max_size : _capacity, size);
 
     FileBufferHead *b;
-    if((_size + load_size) > FILE_BUFFER_SIZE) {
-        do {
-            b = FileBuffer::get(lru.begin()->key());
-            if(b->locked) {
-                // wait
-                SLOG(FS, "FileBuffer: Waiting for eviction of block <" << b->key() << ">");
-                ThreadManager::get().wait_for(b->unlock);
-            }
-            else {
-                SLOG(FS, "FileBuffer: Evicting block <" << b->key() << ">");
-                lru.removeFirst();
-                ht.remove(b);
-                if(b->dirty)
-                    flush_chunk(b);
-                // revoke all subsets
-                VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, b->_data.sel(), 1));
-                _size -= b->_size;
-                delete b;
-            }
+    while((_size + load_size) > _capacity) {
+        b = victim();
+        if(b->locked) {
+            // wait
+            SLOG(FS, "FileBuffer: Waiting for eviction of block <" << b->key() << ">");
+            ThreadManager::get().wait_for(b->unlock);
         }
-        while((_size + load_size) > FILE_BUFFER_SIZE);
+        else
+            evict_chunk(b, !b->_frequent);
     }
 
     b = new FileBufferHead(bno, load_size, _blocksize);
 
     _size += b->_size;
     ht.insert(b);
-    lru.append(b);
+    if(frequent) {
+        _frequent_stats.misses++;
+        b->_frequent = true;
+        lru.append(b);
+    }
+    else {
+        _recent_stats.misses++;
+        _recent_size += b->_size;
+        if(advice == File::NOREUSE)
+            _recent.prepend(b);
+        else
+            _recent.append(b);
+    }
 
     // load from disk
     SLOG(FS, "FileBuffer: Allocating blocks <" << b->key() << "," << b->_size << ">"
-                                               << (load ? " : loading" : ""));
+                                               << (load ? " : loading" : "")
+                                               << (frequent ? " (frequent)" : ""));
     _backend->load_data(b->_data, b->key(), b->_size, load, b->unlock);
 
     b->locked = false;
@@ -110,10 +186,118 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
     Errors::Code res = Syscalls::get().derivemem(sel, b->_data.sel(), 0, load_size * _blocksize, perms);
     if(res != Errors::NONE)
         return 0;
-    b->dirty = dirty;
+    if(dirty) {
+        FileBufferHead::mark(b->_pending_bits, 0, load_size, true);
+        b->dirty = true;
+    }
     return load_size * _blocksize;
 }
 
+FileBufferHead *FileBuffer::victim() {
+    // the recent list may only use a quarter of the buffer, unless there is nothing else
+    if(_recent.length() > 0 && (_recent_size > _capacity / 4 || lru.length() == 0))
+        return static_cast<FileBufferHead*>(&*_recent.begin());
+    return static_cast<FileBufferHead*>(&*lru.begin());
+}
+
+void FileBuffer::evict(blockno_t bno, size_t size) {
+    // flushing blocks the thread; thus, start over after each eviction
+    bool found;
+    do {
+        found = false;
+        for(auto *list : {&_recent, &lru}) {
+            for(auto it = list->begin(); it != list->end(); ++it) {
+                FileBufferHead *b = static_cast<FileBufferHead*>(&*it);
+                if(!b->locked && b->key() < bno + size && bno < b->key() + b->_size) {
+                    evict_chunk(b);
+                    found = true;
+                    break;
+                }
+            }
+            if(found)
+                break;
+        }
+    }
+    while(found);
+}
+
+void FileBuffer::commit(blockno_t bno, size_t blocks, size_t pending) {
+    // if the chunk is gone, it has been written back including all pending blocks
+    FileBufferHead *b = FileBuffer::get(bno);
+    if(!b)
+        return;
+
+    size_t off = bno - b->key();
+    blocks = Math::min(blocks, b->_size - off);
+    pending = Math::min(pending, b->_size - off);
+    FileBufferHead::mark(b->_pending_bits, off, pending, false);
+    if(blocks > 0) {
+        size_t added = FileBufferHead::mark(b->_dirty_bits, off, blocks, true);
+        b->_ndirty += added;
+        b->_wseq++;
+        _dirty_blocks += added;
+        b->dirty = true;
+    }
+}
+
+void FileBuffer::evict_chunk(FileBufferHead *b, bool ghost) {
+    SLOG(FS, "FileBuffer: Evicting block <" << b->key() << ">");
+    if(b->_frequent) {
+        _frequent_stats.evictions++;
+        lru.remove(b);
+    }
+    else {
+        _recent_stats.evictions++;
+        _recent.remove(b);
+        _recent_size -= b->_size;
+    }
+    ht.remove(b);
+    if(b->dirty)
+        flush_chunk(b);
+    // revoke all subsets
+    VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, b->_data.sel(), 1));
+    _size -= b->_size;
+    if(ghost)
+        add_ghost(b->key(), b->_size);
+    delete b;
+}
+
+void FileBuffer::add_ghost(blockno_t bno, size_t size) {
+    // ghosts may overlap, but not start at the same block
+    FileBufferGhost *old = _ghost_tree.find(bno);
+    if(old && old->key() == bno) {
+        _ghost_tree.remove(old);
+        _ghosts.remove(old);
+        _ghost_size -= old->_size;
+        delete old;
+    }
+
+    FileBufferGhost *g = new FileBufferGhost(bno, size);
+    _ghost_tree.insert(g);
+    _ghosts.append(g);
+    _ghost_size += size;
+
+    // remember as many blocks as half of the buffer holds
+    while(_ghost_size > _capacity / 2) {
+        g = &*_ghosts.begin();
+        _ghost_tree.remove(g);
+        _ghosts.remove(g);
+        _ghost_size -= g->_size;
+        _ghost_stats.evictions++;
+        delete g;
+    }
+}
+
+void FileBuffer::print_stats(OStream &os) const {
+    os << "FileBuffer: capacity=" << _capacity << " blocks\n";
+    os << "  recent  : hits=" << _recent_stats.hits << " misses=" << _recent_stats.misses
+       << " evictions=" << _recent_stats.evictions << "\n";
+    os << "  frequent: hits=" << _frequent_stats.hits << " misses=" << _frequent_stats.misses
+       << " evictions=" << _frequent_stats.evictions << "\n";
+    os << "  ghosts  : hits=" << _ghost_stats.hits << " misses=" << _ghost_stats.misses
+       << " evictions=" << _ghost_stats.evictions << "\n";
+}
+
 FileBufferHead *FileBuffer::get(blockno_t bno) {
     FileBufferHead *b = reinterpret_cast<FileBufferHead*>(ht.find(bno));
     if(b)
@@ -121,18 +305,86 @@ FileBufferHead *FileBuffer::get(blockno_t bno) {
     return nullptr;
 }
 
-void FileBuffer::flush_chunk(BufferHead *b) {
+size_t FileBuffer::store_runs(FileBufferHead *b, bool pending) {
+    size_t total = 0;
+    size_t i = 0;
+    while(i < b->_size) {
+        if(!(pending ? b->written(i) : FileBufferHead::test(b->_dirty_bits, i))) {
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        while(i < b->_size && (pending ? b->written(i) : FileBufferHead::test(b->_dirty_bits, i)))
+            i++;
+        SLOG(FS, "FileBuffer: Write back blocks <" << (b->key() + start) << "," << (i - start) << ">");
+        _backend->store_data(b->key(), start * _blocksize, i - start, b->unlock);
+        total += i - start;
+    }
+    return total;
+}
+
+void FileBuffer::flush_chunk(BufferHead *bh) {
+    FileBufferHead *b = static_cast<FileBufferHead*>(bh);
     b->locked = true;
 
-    // TODO track the dirty regions instead of writing back the whole buffer
-    SLOG(FS, "FileBuffer: Write back blocks <" << b->key() << "," << b->_size << ">");
-    _backend->store_data(b->key(), b->_size, b->unlock);
+    // write back the runs of written blocks
+    store_runs(b, true);
 
+    _dirty_blocks -= b->_ndirty;
+    b->clear_bits();
     b->dirty  = false;
     b->locked = false;
 }
 
+size_t FileBuffer::write_back(size_t limit) {
+    size_t total = 0;
+    // storing blocks the thread and others might change the lists; thus, start over each time
+    while(_dirty_blocks > limit) {
+        FileBufferHead *victim = nullptr;
+        for(auto *list : {&_recent, &lru}) {
+            for(auto it = list->begin(); it != list->end(); ++it) {
+                FileBufferHead *b = static_cast<FileBufferHead*>(&*it);
+                if(!b->locked && b->_ndirty > 0) {
+                    victim = b;
+                    break;
+                }
+            }
+            if(victim)
+                break;
+        }
+        if(!victim)
+            break;
+
+        victim->locked = true;
+        size_t wseq = victim->_wseq;
+        total += store_runs(victim, false);
+
+        // data that has been committed in the meantime has to be written again
+        size_t words = (victim->_size + FileBufferHead::WORD_BITS - 1) / FileBufferHead::WORD_BITS;
+        if(victim->_wseq == wseq) {
+            memset(victim->_dirty_bits, 0, words * sizeof(FileBufferHead::word_t));
+            _dirty_blocks -= victim->_ndirty;
+            victim->_ndirty = 0;
+        }
+
+        // blocks that are still handed out for writing keep the chunk dirty
+        victim->dirty = false;
+        for(size_t i = 0; i < words; ++i) {
+            if(victim->_dirty_bits[i] | victim->_pending_bits[i]) {
+                victim->dirty = true;
+                break;
+            }
+        }
+        victim->locked = false;
+    }
+    return total;
+}
+
 void FileBuffer::flush() {
+    if(ServiceLog::level & ServiceLog::FS)
+        print_stats(Serial::get());
+
     while(!ht.empty()) {
         FileBufferHead *b = reinterpret_cast<FileBufferHead *>(ht.remove_root());
         if(b->dirty)
@@ -19,6 +19,8 @@
 
 #include <fs/internal.h>
 
+#include <m3/vfs/File.h>
+
 #include "Buffer.h"
 
 struct InodeExt : public m3::DListItem {
@@ -35,29 +37,130 @@ struct InodeExt : public m3::DListItem {
 class FileBufferHead : public BufferHead {
     friend class FileBuffer;
 
+    using word_t = uint64_t;
+    static const size_t WORD_BITS = sizeof(word_t) * 8;
+
 public:
     explicit FileBufferHead(m3::blockno_t bno, size_t size, size_t blocksize);
+    ~FileBufferHead();
 
 private:
+    static bool test(const word_t *bits, size_t block) {
+        return (bits[block / WORD_BITS] & (static_cast<word_t>(1) << (block % WORD_BITS))) != 0;
+    }
+    bool written(size_t block) const {
+        return test(_dirty_bits, block) || test(_pending_bits, block);
+    }
+    static size_t mark(word_t *bits, size_t off, size_t count, bool set);
+    void clear_bits();
+
     m3::MemGate _data;
     m3::DList<InodeExt> _extents;
+    // whether the chunk is in the frequent list instead of the recent one
+    bool _frequent;
+    // per block: committed writes and handed out write access, that has not been committed yet
+    word_t *_dirty_bits;
+    word_t *_pending_bits;
+    // the number of bits set in _dirty_bits
+    size_t _ndirty;
+    // incremented by every commit to detect writes during a write back
+    size_t _wseq;
 };
 
+/**
+ * Remembers a chunk that has recently been evicted from the recent list. If it is requested again
+ * before the ghost is dropped, it is considered frequently used.
+ */
+struct FileBufferGhost : public m3::TreapNode<FileBufferGhost, m3::blockno_t>, public m3::DListItem {
+    explicit FileBufferGhost(m3::blockno_t bno, size_t size)
+        : TreapNode(bno),
+          DListItem(),
+          _size(size) {
+    }
+
+    bool matches(m3::blockno_t bno) {
+        return (key() <= bno) && (bno < key() + _size);
+    }
+
+    size_t _size;
+};
+
+/**
+ * The buffer for file data. It uses the 2Q replacement policy to be scan resistant: new chunks are
+ * put into the recent list (FIFO), which gets a quarter of the capacity. Chunks evicted from there
+ * leave a ghost behind. Only if a ghost is hit, the chunk is loaded into the frequent list (LRU).
+ * Thus, a large sequential scan only replaces the recent list.
+ */
 class FileBuffer : public Buffer {
-    static constexpr size_t FILE_BUFFER_SIZE    = 16384; // at least 128
     static constexpr size_t LOAD_LIMIT          = 128;
 
 public:
-    explicit FileBuffer(size_t blocksize, Backend *backend, size_t max_load);
+    static constexpr size_t DEF_SIZE            = 16384;
+    static constexpr size_t MIN_SIZE            = 128;
+
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
 
+    explicit FileBuffer(size_t blocksize, Backend *backend, size_t max_load,
+                        size_t size = DEF_SIZE);
+
+    /**
+     * Hands out a capability for the blocks <bno>..<bno>+<size>-1, as far as they are in one chunk.
+     * If <dirty> is true, the blocks are written back until commit() says otherwise.
+     */
     size_t get_extent(m3::blockno_t bno, size_t size, capsel_t sel, int perms, size_t accessed,
-                      bool load = true, bool dirty = false);
+                      bool load = true, bool dirty = false,
+                      m3::File::Advice advice = m3::File::NORMAL);
+    void evict(m3::blockno_t bno, size_t size);
+    bool contains(m3::blockno_t bno) {
+        return get(bno) != nullptr;
+    }
+    /**
+     * Marks the blocks <bno>..<bno>+<blocks>-1 as written and revokes the write-back of the other
+     * handed out blocks up to <bno>+<pending>-1, which have not been touched.
+     */
+    void commit(m3::blockno_t bno, size_t blocks, size_t pending);
     void flush() override;
 
+    /**
+     * @return the number of blocks with committed, but not yet written back data
+     */
+    size_t dirty_blocks() const {
+        return _dirty_blocks;
+    }
+    /**
+     * Writes back committed data, starting with the chunks that are evicted first, until at most
+     * <limit> dirty blocks are left. Blocks that are handed out for writing stay pending.
+     *
+     * @return the number of written blocks
+     */
+    size_t write_back(size_t limit);
+
+    void print_stats(m3::OStream &os) const;
+
 private:
+    FileBufferHead *victim();
+    void evict_chunk(FileBufferHead *b, bool ghost = false);
+    void add_ghost(m3::blockno_t bno, size_t size);
     FileBufferHead *get(m3::blockno_t bno) override;
     void flush_chunk(BufferHead *b) override;
+    size_t store_runs(FileBufferHead *b, bool pending);
 
+    // the number of blocks in total, in the recent list and remembered by ghosts
     size_t _size;
+    size_t _recent_size;
+    size_t _ghost_size;
+    size_t _dirty_blocks;
+    size_t _capacity;
     size_t _max_load;
+    // the frequent list is Buffer::lru
+    m3::DList<BufferHead> _recent;
+    m3::DList<FileBufferGhost> _ghosts;
+    m3::Treap<FileBufferGhost> _ghost_tree;
+    Stats _recent_stats;
+    Stats _frequent_stats;
+    Stats _ghost_stats;
 };
@@ -28,13 +28,31 @@ MetaBufferHead::MetaBufferHead(blockno_t bno, size_t size, size_t off, char *dat
       _linkcount(0) {
 }
 
-MetaBuffer::MetaBuffer(size_t blocksize, Backend *backend)
+MetaBuffer::MetaBuffer(size_t blocksize, Backend *backend, size_t size)
     : Buffer(blocksize, backend),
-      _blocks(new char[_blocksize * META_BUFFER_SIZE]) {
-    for(size_t i = 0; i < META_BUFFER_SIZE; i++)
+      _capacity(Math::max(size, MIN_SIZE)),
+      _blocks(new char[_blocksize * _capacity]),
+      _used(),
+      _stats() {
+    _backend->alloc_meta(_capacity);
+    for(size_t i = 0; i < _capacity; i++)
         lru.append(new MetaBufferHead(0, 1, i, _blocks + i * _blocksize));
 }
 
+void MetaBuffer::use(MetaBufferHead *b) {
+    if(b->_linkcount++ == 0) {
+        lru.remove(b);
+        _used.append(b);
+    }
+}
+
+void MetaBuffer::unuse(MetaBufferHead *b) {
+    if(--b->_linkcount == 0) {
+        _used.remove(b);
+        lru.append(b);
+    }
+}
+
 void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
     MetaBufferHead *b;
     while(true) {
@@ -43,8 +61,8 @@ void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
             if(b->locked)
                 ThreadManager::get().wait_for(b->unlock);
             else {
-                lru.moveToEnd(b);
-                b->_linkcount++;
+                _stats.hits++;
+                use(b);
                 b->dirty |= dirty;
                 SLOG(FS, "MetaBuffer: Found cached block <" << b->key() << ">, Links: "
                                                             << b->_linkcount);
@@ -56,30 +74,31 @@ void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
             break;
     }
 
-    // find first non-used block
-    for(auto it = lru.begin(); it != lru.end(); ++it) {
-        auto mb = static_cast<MetaBufferHead*>(&*it);
-        if(mb->_linkcount == 0) {
-            b = mb;
-            break;
-        }
-    }
+    // the least recently used block that is not in use
+    _stats.misses++;
+    if(lru.length() == 0)
+        PANIC("MetaBuffer: all " << _capacity << " blocks are in use");
+    b = static_cast<MetaBufferHead*>(&*lru.begin());
+    // take it out of lru before we block, so that no other thread picks it as well
+    use(b);
 
     // write-back, if necessary
     if(b->key()) {
+        _stats.evictions++;
         ht.remove(b);
-        if(b->dirty)
+        if(b->dirty) {
+            _stats.writebacks++;
             flush_chunk(b);
+        }
     }
 
     b->key(bno);
+    b->locked = true;
     ht.insert(b);
 
     _backend->load_meta(b->_data, b->_off, bno, b->unlock);
 
-    b->_linkcount = 1;
     b->dirty = dirty;
-    lru.moveToEnd(b);
     SLOG(FS, "MetaBuffer: Load new block <" << b->key() << ">, Links: " << b->_linkcount);
     b->locked = false;
 
@@ -90,7 +109,7 @@ void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
 void MetaBuffer::quit(MetaBufferHead *b) {
     assert(b->_linkcount > 0);
     SLOG(FS, "MetaBuffer: Dereferencing block <" << b->key() << ">, Links: " << b->_linkcount);
-    b->_linkcount--;
+    unuse(b);
 }
 
 MetaBufferHead *MetaBuffer::get(blockno_t bno) {
@@ -121,6 +140,9 @@ void MetaBuffer::write_back(blockno_t bno) {
 }
 
 void MetaBuffer::flush() {
+    if(ServiceLog::level & ServiceLog::FS)
+        print_stats(Serial::get());
+
     while(!ht.empty()) {
         MetaBufferHead *b = reinterpret_cast<MetaBufferHead*>(ht.remove_root());
         if(b->dirty)
@@ -128,6 +150,36 @@ void MetaBuffer::flush() {
     }
 }
 
+size_t MetaBuffer::write_back_unused() {
+    // blocks that are in use might be in an inconsistent state. storing blocks the thread, so that
+    // the list might change; thus, start over after each block.
+    size_t total = 0;
+    bool found;
+    do {
+        found = false;
+        for(auto it = lru.begin(); it != lru.end(); ++it) {
+            auto b = static_cast<MetaBufferHead*>(&*it);
+            if(b->key() && b->dirty && !b->locked) {
+                // keep it from being evicted meanwhile
+                use(b);
+                flush_chunk(b);
+                unuse(b);
+                total++;
+                found = true;
+                break;
+            }
+        }
+    }
+    while(found);
+    return total;
+}
+
+void MetaBuffer::print_stats(OStream &os) const {
+    os << "MetaBuffer: capacity=" << _capacity << " blocks\n";
+    os << "  hits=" << _stats.hits << " misses=" << _stats.misses
+       << " evictions=" << _stats.evictions << " writebacks=" << _stats.writebacks << "\n";
+}
+
 bool MetaBuffer::dirty(blockno_t bno) {
     MetaBufferHead *b = get(bno);
     if(b)
@@ -41,24 +41,45 @@ private:
 
 /*
  * stores single blocks
- * lru is the list of free blocks
- * blocks will be freed if no session uses them
+ * lru is the list of blocks that are not used by any request, least recently used first. blocks
+ * in use are kept in a separate list, so that the victim is always the first block in lru.
  */
 class MetaBuffer : public Buffer {
 public:
-    static constexpr size_t META_BUFFER_SIZE    = 512;
+    static constexpr size_t DEF_SIZE            = 512;
+    static constexpr size_t MIN_SIZE            = 32;
 
-    explicit MetaBuffer(size_t blocksize, Backend *backend);
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t writebacks;
+    };
+
+    explicit MetaBuffer(size_t blocksize, Backend *backend, size_t size = DEF_SIZE);
+
+    size_t capacity() const {
+        return _capacity;
+    }
 
     void *get_block(Request &r, m3::blockno_t bno, bool dirty = false);
     void quit(MetaBufferHead *b);
     void write_back(m3::blockno_t bno);
     void flush() override;
     bool dirty(m3::blockno_t);
+    size_t write_back_unused();
+
+    void print_stats(m3::OStream &os) const;
 
 private:
+    void use(MetaBufferHead *b);
+    void unuse(MetaBufferHead *b);
     MetaBufferHead *get(m3::blockno_t bno) override;
     void flush_chunk(BufferHead *b) override;
 
+    size_t _capacity;
     char *_blocks;
+    // the blocks with _linkcount > 0
+    m3::DList<BufferHead> _used;
+    Stats _stats;
 };
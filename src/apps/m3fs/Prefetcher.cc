@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Services.h>
+
+#include <thread/ThreadManager.h>
+
+#include <m3/com/MemGate.h>
+#include <m3/VPE.h>
+
+#include "FileBuffer.h"
+#include "Prefetcher.h"
+
+using namespace m3;
+
+void Prefetcher::enqueue(blockno_t bno, size_t blocks, size_t accessed) {
+    if(_filebuffer.contains(bno)) {
+        _stats.cached++;
+        return;
+    }
+    // don't load the same blocks twice
+    for(size_t i = 0; i < _count; ++i) {
+        if(_reqs[(_head + i) % MAX_REQS].bno == bno)
+            return;
+    }
+    if(_count == MAX_REQS) {
+        _stats.dropped++;
+        return;
+    }
+
+    Req &req = _reqs[(_head + _count) % MAX_REQS];
+    req.bno = bno;
+    req.blocks = blocks;
+    req.accessed = accessed;
+    _count++;
+    _stats.queued++;
+}
+
+void Prefetcher::work() {
+    // the disk accesses block us and another thread might run the workloop meanwhile
+    if(_running || _count == 0)
+        return;
+
+    _running = true;
+    // the capability is only used to load the blocks
+    capsel_t sel = VPE::self().alloc_sel();
+    while(_count > 0) {
+        Req req = _reqs[_head];
+        _head = (_head + 1) % MAX_REQS;
+        _count--;
+
+        // the client might have been faster
+        if(_filebuffer.contains(req.bno)) {
+            _stats.cached++;
+            continue;
+        }
+
+        SLOG(FS, "Prefetcher: loading blocks <" << req.bno << "," << req.blocks << ">");
+        if(_filebuffer.get_extent(req.bno, req.blocks, sel, MemGate::R, req.accessed, true, false,
+                                  File::SEQUENTIAL) > 0) {
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sel, 1));
+            _stats.loaded++;
+        }
+    }
+    _running = false;
+    if(_waiter) {
+        ThreadManager::get().notify(_waiter);
+        _waiter = 0;
+    }
+}
+
+void Prefetcher::wait() {
+    while(_running) {
+        _waiter = ThreadManager::get().get_wait_event();
+        ThreadManager::get().wait_for(_waiter);
+    }
+}
+
+void Prefetcher::print_stats(OStream &os) const {
+    os << "Prefetcher: queued=" << _stats.queued << " loaded=" << _stats.loaded
+       << " cached=" << _stats.cached << " dropped=" << _stats.dropped << "\n";
+}
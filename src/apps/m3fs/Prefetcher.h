@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/WorkLoop.h>
+#include <base/stream/OStream.h>
+
+#include <fs/internal.h>
+
+class FileBuffer;
+
+/**
+ * Loads file data into the FileBuffer ahead of time. Sessions that are read sequentially enqueue
+ * the blocks they will need next. The loads are done as part of the workloop, i.e., after the
+ * current request has been answered. Since the disk accesses block the thread, other threads
+ * continue to serve requests meanwhile.
+ */
+class Prefetcher : public m3::WorkItem {
+    static const size_t MAX_REQS    = 16;
+
+    struct Req {
+        m3::blockno_t bno;
+        size_t blocks;
+        size_t accessed;
+    };
+
+public:
+    struct Stats {
+        size_t queued;
+        size_t loaded;
+        size_t cached;
+        size_t dropped;
+    };
+
+    explicit Prefetcher(FileBuffer &filebuffer)
+        : m3::WorkItem(),
+          _filebuffer(filebuffer),
+          _head(),
+          _count(),
+          _running(),
+          _waiter(),
+          _reqs(),
+          _stats() {
+    }
+
+    /**
+     * Enqueues the load of the blocks <bno>..<bno>+<blocks>-1. If the queue is full, the request
+     * is dropped.
+     */
+    void enqueue(m3::blockno_t bno, size_t blocks, size_t accessed);
+
+    virtual void work() override;
+
+    /**
+     * Blocks the current thread until the prefetching that is currently running, if any, is finished.
+     */
+    void wait();
+
+    const Stats &stats() const {
+        return _stats;
+    }
+    void print_stats(m3::OStream &os) const;
+
+private:
+    FileBuffer &_filebuffer;
+    size_t _head;
+    size_t _count;
+    bool _running;
+    event_t _waiter;
+    Req _reqs[MAX_REQS];
+    Stats _stats;
+};
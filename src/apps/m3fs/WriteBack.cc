@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Services.h>
+
+#include <thread/ThreadManager.h>
+
+#include "FSHandle.h"
+#include "WriteBack.h"
+
+using namespace m3;
+
+void WriteBack::work() {
+    // the disk accesses block us and another thread might run the workloop meanwhile
+    if(_running)
+        return;
+
+    bool periodic = ++_ticks >= MAX_AGE;
+    FileBuffer &fb = _handle.filebuffer();
+    if(!periodic && fb.dirty_blocks() <= _high)
+        return;
+
+    _running = true;
+    _ticks = 0;
+    _stats.runs++;
+    if(periodic)
+        _stats.periodic++;
+
+    SLOG(FS, "WriteBack: starting with " << fb.dirty_blocks() << " dirty blocks"
+                                         << (periodic ? " (periodic)" : ""));
+    _stats.file_blocks += fb.write_back(periodic ? 0 : _low);
+    if(periodic)
+        _stats.meta_blocks += _handle.metabuffer().write_back_unused();
+
+    _running = false;
+    if(_waiter) {
+        ThreadManager::get().notify(_waiter);
+        _waiter = 0;
+    }
+}
+
+void WriteBack::wait() {
+    while(_running) {
+        _waiter = ThreadManager::get().get_wait_event();
+        ThreadManager::get().wait_for(_waiter);
+    }
+}
+
+void WriteBack::print_stats(OStream &os) const {
+    os << "WriteBack: runs=" << _stats.runs << " periodic=" << _stats.periodic
+       << " file_blocks=" << _stats.file_blocks << " meta_blocks=" << _stats.meta_blocks << "\n";
+}
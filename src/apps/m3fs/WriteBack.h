@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/WorkLoop.h>
+#include <base/stream/OStream.h>
+
+class FSHandle;
+
+/**
+ * Writes back dirty data in the background, so that evictions on the request path find clean
+ * chunks. It runs as part of the workloop; since the disk accesses block the thread, other
+ * threads continue to serve requests meanwhile.
+ *
+ * A write-back is started if the committed, dirty blocks in the FileBuffer exceed the high
+ * watermark or if the last one is MAX_AGE workloop ticks ago. The former writes back until the
+ * low watermark is reached, the latter everything, including the unused blocks of the MetaBuffer.
+ */
+class WriteBack : public m3::WorkItem {
+public:
+    static const size_t MAX_AGE     = 256;
+
+    struct Stats {
+        size_t runs;
+        size_t periodic;
+        size_t file_blocks;
+        size_t meta_blocks;
+    };
+
+    explicit WriteBack(FSHandle &handle, size_t high)
+        : m3::WorkItem(),
+          _handle(handle),
+          _high(high),
+          _low(high / 2),
+          _ticks(),
+          _running(),
+          _waiter(),
+          _stats() {
+    }
+
+    virtual void work() override;
+
+    /**
+     * Blocks the current thread until the write-back that is currently running, if any, is finished.
+     */
+    void wait();
+
+    const Stats &stats() const {
+        return _stats;
+    }
+    void print_stats(m3::OStream &os) const;
+
+private:
+    FSHandle &_handle;
+    size_t _high;
+    size_t _low;
+    size_t _ticks;
+    bool _running;
+    event_t _waiter;
+    Stats _stats;
+};
@@ -18,6 +18,8 @@
 
 #include <fs/internal.h>
 
+#include <m3/vfs/File.h>
+
 #include "../sess/Request.h"
 
 class Backend {
@@ -25,16 +27,21 @@ public:
     virtual ~Backend() {
     }
 
+    virtual void alloc_meta(size_t blocks) = 0;
     virtual void load_meta(void *dst, size_t dst_off, m3::blockno_t bno, event_t unlock) = 0;
     virtual void load_data(m3::MemGate &mem, m3::blockno_t bno, size_t blocks, bool init, event_t unlock) = 0;
 
     virtual void store_meta(const void *src, size_t src_off, m3::blockno_t bno, event_t unlock) = 0;
-    virtual void store_data(m3::blockno_t bno, size_t blocks, event_t unlock) = 0;
+    virtual void store_data(m3::blockno_t bno, size_t off, size_t blocks, event_t unlock) = 0;
 
     virtual void sync_meta(Request &r, m3::blockno_t bno) = 0;
 
     virtual size_t get_filedata(Request &r, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
-                                bool dirty, bool load, size_t accessed) = 0;
+                                bool dirty, bool load, size_t accessed,
+                                m3::File::Advice advice) = 0;
+    virtual void drop_filedata(Request &r, m3::Extent *ext, size_t extoff, size_t len) = 0;
+    virtual void prefetch_filedata(Request &r, m3::Extent *ext, size_t extoff, size_t accessed) = 0;
+    virtual void commit_filedata(Request &r, m3::blockno_t bno, size_t blocks, size_t pending) = 0;
 
     virtual void clear_extent(Request &r, m3::Extent *ext, size_t accessed) = 0;
 
@@ -33,6 +33,13 @@ public:
           _metabuf() {
     }
 
+    void alloc_meta(size_t blocks) override {
+        // use separate transfer buffer for each entry to allow parallel disk requests
+        size_t size = (_blocksize + MetaBuffer::PRDT_SIZE) * blocks;
+        _metabuf = new m3::MemGate(m3::MemGate::create_global(size, m3::MemGate::RW));
+        // store the MemCap as blockno 0, bc we won't load the superblock again
+        delegate_mem(*_metabuf, 0, 1);
+    }
     void load_meta(void *dst, size_t dst_off, m3::blockno_t bno, event_t unlock) override {
         size_t off = dst_off * (_blocksize + MetaBuffer::PRDT_SIZE);
         _disk->read(0, bno, 1, _blocksize, off);
@@ -52,8 +59,9 @@ public:
         _disk->write(0, bno, 1, _blocksize, off);
         m3::ThreadManager::get().notify(unlock);
     }
-    void store_data(m3::blockno_t bno, size_t blocks, event_t unlock) override {
-        _disk->write(bno, bno, blocks, _blocksize);
+    void store_data(m3::blockno_t bno, size_t off, size_t blocks, event_t unlock) override {
+        // the memory has been delegated for the whole chunk, starting at <bno>
+        _disk->write(bno, bno + off / _blocksize, blocks, _blocksize, off);
         m3::ThreadManager::get().notify(unlock);
     }
 
@@ -73,11 +81,28 @@ public:
     }
 
     size_t get_filedata(Request &r, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
-                        bool dirty, bool load, size_t accessed) override {
+                        bool dirty, bool load, size_t accessed,
+                        m3::File::Advice advice) override {
         size_t first_block = extoff / _blocksize;
         return r.hdl().filebuffer().get_extent(ext->start + first_block,
                                                ext->length - first_block,
-                                               sel, perms, accessed, load, dirty);
+                                               sel, perms, accessed, load, dirty, advice);
+    }
+
+    void drop_filedata(Request &r, m3::Extent *ext, size_t extoff, size_t len) override {
+        size_t first_block = extoff / _blocksize;
+        size_t end_block = m3::Math::min<size_t>(ext->length,
+                                                 (extoff + len + _blocksize - 1) / _blocksize);
+        r.hdl().filebuffer().evict(ext->start + first_block, end_block - first_block);
+    }
+
+    void prefetch_filedata(Request &r, m3::Extent *ext, size_t extoff, size_t accessed) override {
+        size_t first_block = extoff / _blocksize;
+        r.hdl().prefetcher().enqueue(ext->start + first_block, ext->length - first_block, accessed);
+    }
+
+    void commit_filedata(Request &r, m3::blockno_t bno, size_t blocks, size_t pending) override {
+        r.hdl().filebuffer().commit(bno, blocks, pending);
     }
 
     void clear_extent(Request &r, m3::Extent *ext, size_t accessed) override {
@@ -103,12 +128,7 @@ public:
         _disk->read(0, 0, 1, 512);
         tmp.read(&sb, sizeof(sb), 0);
 
-        // use separate transfer buffer for each entry to allow parallel disk requests
         _blocksize = sb.blocksize;
-        size_t size = (_blocksize + MetaBuffer::PRDT_SIZE) * MetaBuffer::META_BUFFER_SIZE;
-        _metabuf = new m3::MemGate(m3::MemGate::create_global(size, m3::MemGate::RW));
-        // store the MemCap as blockno 0, bc we won't load the superblock again
-        delegate_mem(*_metabuf, 0, 1);
     }
 
     void store_sb(m3::SuperBlock &sb) override {
@@ -30,6 +30,9 @@ public:
           _mem(m3::MemGate::create_global_for(fsoff, fssize, m3::MemGate::RWX)) {
     }
 
+    void alloc_meta(size_t) override {
+        // unused
+    }
     void load_meta(void *dst, size_t, m3::blockno_t bno, event_t) override {
         _mem.read(dst, _blocksize, bno * _blocksize);
     }
@@ -40,7 +43,7 @@ public:
     void store_meta(const void *src, size_t, m3::blockno_t bno, event_t) override {
         _mem.write(src, _blocksize, bno * _blocksize);
     }
-    void store_data(m3::blockno_t, size_t, event_t) override {
+    void store_data(m3::blockno_t, size_t, size_t, event_t) override {
         // unused
     }
 
@@ -49,7 +52,7 @@ public:
     }
 
     size_t get_filedata(Request &, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
-                        bool, bool, size_t) override {
+                        bool, bool, size_t, m3::File::Advice) override {
         size_t first_block = extoff / _blocksize;
         size_t bytes = (ext->length - first_block) * _blocksize;
         if(m3::Syscalls::get().derivemem(sel, _mem.sel(), (ext->start + first_block) * _blocksize,
@@ -59,6 +62,18 @@ public:
         return bytes;
     }
 
+    void drop_filedata(Request &, m3::Extent *, size_t, size_t) override {
+        // the data is always in memory
+    }
+
+    void prefetch_filedata(Request &, m3::Extent *, size_t, size_t) override {
+        // the data is always in memory
+    }
+
+    void commit_filedata(Request &, m3::blockno_t, size_t, size_t) override {
+        // the data is written in place
+    }
+
     void clear_extent(Request &, m3::Extent *ext, size_t) override {
         alignas(64) static char zeros[m3::MAX_BLOCK_SIZE];
         for(uint32_t i = 0; i < ext->length; ++i)
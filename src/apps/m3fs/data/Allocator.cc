@@ -16,6 +16,8 @@
 
 #include "Allocator.h"
 
+#include <base/util/Math.h>
+
 #include "../FSHandle.h"
 
 using namespace m3;
@@ -27,106 +29,131 @@ Allocator::Allocator(const char *name, uint32_t first, uint32_t *first_free, uin
       _first_free(first_free),
       _free(free),
       _total(total),
-      _blocks(blocks) {
+      _blocks(blocks),
+      _extents(),
+      _bystart(),
+      _bylen(),
+      _stats() {
     static_assert(sizeof(blockno_t) == sizeof(uint32_t), "Wrong type");
     static_assert(sizeof(inodeno_t) == sizeof(uint32_t), "Wrong type");
 }
 
-uint32_t Allocator::alloc(Request &r, size_t *count) {
-    const size_t perblock = r.hdl().sb().blocksize * 8;
-    const uint32_t lastno = _first + _blocks - 1;
-    const size_t icount = *count;
-    uint32_t no = _first + *_first_free / perblock;
-    size_t total = 0;
-    uint32_t i = *_first_free % perblock;
+Allocator::~Allocator() {
+    ByStart *n;
+    while((n = _bystart.remove_root()) != nullptr)
+        delete n->ext;
+}
 
-    while(total == 0 && no <= lastno) {
-        auto *bytes = reinterpret_cast<Bitmap::word_t*>(r.hdl().metabuffer().get_block(r, no, true));
-        // take care that total_blocks might not be a multiple of perblock
-        size_t max = perblock;
-        if(no == lastno) {
-            max = _total % perblock;
-            max = max == 0 ? perblock : max;
-        }
+void Allocator::load(Request &r) {
+    const uint32_t perblock = r.hdl().sb().blocksize * 8;
+    uint32_t begin = 0;
+    uint32_t run = 0;
+    uint32_t off = 0;
+    for(uint32_t no = _first; no < _first + _blocks; ++no, off += perblock) {
+        auto *bytes = reinterpret_cast<Bitmap::word_t*>(r.hdl().metabuffer().get_block(r, no, false));
         Bitmap bm(bytes);
+        // take care that total_blocks might not be a multiple of perblock
+        uint32_t max = Math::min(perblock, _total - off);
 
-        // first, search quickly until we've found a word that has free bits
-        if(i < max && bm.is_word_set(i)) {
-            // within the first word with free bits, the first free bit is not necessarily
-            // i % Bitmap::WORD_BITS. thus, start from 0 within each word
-            i = (i + Bitmap::WORD_BITS) & ~static_cast<uint32_t>(Bitmap::WORD_BITS - 1);
-            for(; i < max && bm.is_word_set(i); i += Bitmap::WORD_BITS)
-                ;
-            if(i < max) {
-                // now walk to the actual first free bit
-                for(; bm.is_set(i); ++i)
-                    ;
+        for(uint32_t i = 0; i < max; ) {
+            // skip full words and take free words at once
+            if((i % Bitmap::WORD_BITS) == 0 && max - i >= Bitmap::WORD_BITS) {
+                if(bm.is_word_set(i)) {
+                    if(run > 0)
+                        add_range(begin, run);
+                    run = 0;
+                    i += Bitmap::WORD_BITS;
+                    continue;
+                }
+                if(bm.is_word_free(i)) {
+                    if(run == 0)
+                        begin = off + i;
+                    run += Bitmap::WORD_BITS;
+                    i += Bitmap::WORD_BITS;
+                    continue;
+                }
             }
-        }
 
-        // now walk until its aligned (i < max is not required here since a block is always a multiple
-        // of Bitmap::WORD_BITS and we run only until i % Bitmap::WORD_BITS == 0)
-        for(; (i % Bitmap::WORD_BITS) != 0 && total < icount; ++i) {
-            if(!bm.is_set(i)) {
-                bm.set(i);
-                total++;
+            if(bm.is_set(i)) {
+                if(run > 0)
+                    add_range(begin, run);
+                run = 0;
             }
-            else if(total > 0)
-                break;
-        }
-
-        // now allocate in words
-        for(; (icount - total) >= Bitmap::WORD_BITS && (max - i) >= Bitmap::WORD_BITS; i += Bitmap::WORD_BITS) {
-            if(bm.is_word_free(i)) {
-                bm.set_word(i);
-                total += Bitmap::WORD_BITS;
+            else {
+                if(run == 0)
+                    begin = off + i;
+                run++;
             }
-            else if(total > 0)
-                break;
+            i++;
         }
 
-        if(total == 0) {
-            for(; i < max && total < icount; ++i) {
-                if(!bm.is_set(i)) {
-                    bm.set(i);
-                    total++;
-                }
-            }
+        r.pop_meta();
+    }
+    if(run > 0)
+        add_range(begin, run);
+
+    SLOG(FS, _name << ": indexed " << _extents << " free ranges");
+}
+
+uint32_t Allocator::alloc(Request &r, size_t *count, uint32_t goal) {
+    FreeExtent *ext = nullptr;
+    uint32_t start = 0;
+
+    // continue at the goal, if it's free
+    if(goal != 0) {
+        ByStart *n = _bystart.find_le(goal);
+        if(n && goal < n->ext->start + n->ext->count) {
+            ext = n->ext;
+            start = goal;
+            _stats.goal_hits++;
         }
+    }
+
+    // otherwise, take the smallest range that is large enough or the largest one, if there is none
+    if(ext == nullptr) {
+        ByLen *n = _bylen.find_ge(static_cast<uint64_t>(*count) << 32);
+        if(n)
+            _stats.best_fits++;
         else {
-            // there might be something left
-            for(; i < max && total < icount && !bm.is_set(i); ++i) {
-                bm.set(i);
-                total++;
+            n = _bylen.find_le(static_cast<uint64_t>(-1));
+            if(n == nullptr) {
+                *count = 0;
+                return 0;
             }
+            _stats.partial++;
         }
-
-        r.pop_meta();
-        if(total == 0) {
-            no++;
-            i = 0;
-        }
+        ext = n->ext;
+        start = ext->start;
     }
 
+    uint32_t total = static_cast<uint32_t>(
+        Math::min(*count, static_cast<size_t>(ext->start + ext->count - start)));
+    // remove it from the index first, because updating the bitmap might block
+    take_range(ext, start, total);
+    update_bitmap(r, start, total, true);
+
     assert(*_free >= total);
     *_free -= total;
+    ByStart *first = _bystart.find_ge(0);
+    *_first_free = first ? first->key() : _total;
     *count = total;
-    if(total == 0)
-        return 0;
-    uint32_t off = (no - _first) * perblock + i;
-    *_first_free = off;
-    uint32_t start = off - total;
     SLOG(FS, _name << ": allocated " << start << ".." << (start + total - 1));
     return start;
 }
 
 void Allocator::free(Request &r, uint32_t start, size_t count) {
-    size_t perblock = r.hdl().sb().blocksize * 8;
-    uint32_t no = _first + start / perblock;
     if(start < *_first_free)
         *_first_free = start;
     *_free += count;
     SLOG(FS, _name << ": free'd " << start << ".." << (start + count - 1));
+    // update the bitmap first, so that nobody can allocate the range before we're done
+    update_bitmap(r, start, count, false);
+    add_range(start, static_cast<uint32_t>(count));
+}
+
+void Allocator::update_bitmap(Request &r, uint32_t start, size_t count, bool set) {
+    size_t perblock = r.hdl().sb().blocksize * 8;
+    uint32_t no = _first + start / perblock;
     while(count > 0) {
         auto *bytes = reinterpret_cast<Bitmap::word_t*>(r.hdl().metabuffer().get_block(r, no, true));
         Bitmap bm(bytes);
@@ -136,21 +163,33 @@ void Allocator::free(Request &r, uint32_t start, size_t count) {
         uint32_t begin = i;
         uint32_t end = Math::min(static_cast<uint32_t>(i + count), static_cast<uint32_t>(perblock));
         for(; (i % Bitmap::WORD_BITS) != 0 && i < end; ++i) {
-            assert(bm.is_set(i));
-            bm.unset(i);
+            assert(bm.is_set(i) != set);
+            if(set)
+                bm.set(i);
+            else
+                bm.unset(i);
         }
 
-        // now clear in word-steps
+        // now change it in word-steps
         uint32_t wend = end & ~static_cast<uint32_t>(Bitmap::WORD_BITS - 1);
         for(; i < wend; i += Bitmap::WORD_BITS) {
-            assert(bm.is_word_set(i));
-            bm.clear_word(i);
+            if(set) {
+                assert(bm.is_word_free(i));
+                bm.set_word(i);
+            }
+            else {
+                assert(bm.is_word_set(i));
+                bm.clear_word(i);
+            }
         }
 
         // maybe, there is something left
         for(; i < end; ++i) {
-            assert(bm.is_set(i));
-            bm.unset(i);
+            assert(bm.is_set(i) != set);
+            if(set)
+                bm.set(i);
+            else
+                bm.unset(i);
         }
 
         // to next bitmap block
@@ -160,3 +199,71 @@ void Allocator::free(Request &r, uint32_t start, size_t count) {
         no++;
     }
 }
+
+void Allocator::insert(FreeExtent *ext) {
+    ext->bystart.key(ext->start);
+    ext->bylen.key((static_cast<uint64_t>(ext->count) << 32) | ext->start);
+    _bystart.insert(&ext->bystart);
+    _bylen.insert(&ext->bylen);
+    _extents++;
+}
+
+void Allocator::remove(FreeExtent *ext) {
+    _bystart.remove(&ext->bystart);
+    _bylen.remove(&ext->bylen);
+    _extents--;
+}
+
+void Allocator::add_range(uint32_t start, uint32_t count) {
+    FreeExtent *ext;
+
+    // merge with the preceding range
+    ByStart *prev = _bystart.find_le(start);
+    assert(!prev || prev->ext->start + prev->ext->count <= start);
+    if(prev && prev->ext->start + prev->ext->count == start) {
+        ext = prev->ext;
+        remove(ext);
+        ext->count += count;
+    }
+    else
+        ext = new FreeExtent(start, count);
+
+    // merge with the following range
+    ByStart *next = _bystart.find_ge(start + count);
+    if(next && next->key() == start + count) {
+        FreeExtent *n = next->ext;
+        remove(n);
+        ext->count += n->count;
+        delete n;
+    }
+
+    insert(ext);
+}
+
+void Allocator::take_range(FreeExtent *ext, uint32_t start, uint32_t count) {
+    uint32_t end = ext->start + ext->count;
+    assert(start >= ext->start && start + count <= end);
+
+    remove(ext);
+    if(start > ext->start) {
+        // keep the part before the range and add the part behind it, if any
+        ext->count = start - ext->start;
+        insert(ext);
+        if(start + count < end)
+            insert(new FreeExtent(start + count, end - (start + count)));
+    }
+    else {
+        ext->start += count;
+        ext->count -= count;
+        if(ext->count > 0)
+            insert(ext);
+        else
+            delete ext;
+    }
+}
+
+void Allocator::print_stats(OStream &os) const {
+    os << "Allocator[" << _name << "]: free=" << *_free << " ranges=" << _extents << "\n";
+    os << "  goal_hits=" << _stats.goal_hits << " best_fits=" << _stats.best_fits
+       << " partial=" << _stats.partial << "\n";
+}
@@ -16,29 +16,104 @@
 
 #pragma once
 
+#include <base/col/Treap.h>
+#include <base/stream/OStream.h>
+
 #include <fs/internal.h>
 
 #include "../sess/Request.h"
 
 class FSHandle;
 
+/**
+ * Allocates blocks or inodes. The bitmap on disk stays the persistent state, but all free ranges
+ * are additionally kept in memory, indexed by their start and by their length. The index is built
+ * by load() at mount time, so that alloc() does not need to scan the bitmap. Instead, it continues
+ * at a given goal, if possible, and takes the smallest free range that is large enough otherwise.
+ */
 class Allocator {
+    struct FreeExtent;
+
+    struct ByStart : public m3::TreapNode<ByStart, uint32_t> {
+        explicit ByStart(FreeExtent *_ext)
+            : m3::TreapNode<ByStart, uint32_t>(0),
+              ext(_ext) {
+        }
+        FreeExtent *ext;
+    };
+
+    struct ByLen : public m3::TreapNode<ByLen, uint64_t> {
+        explicit ByLen(FreeExtent *_ext)
+            : m3::TreapNode<ByLen, uint64_t>(0),
+              ext(_ext) {
+        }
+        FreeExtent *ext;
+    };
+
+    struct FreeExtent {
+        explicit FreeExtent(uint32_t _start, uint32_t _count)
+            : bystart(this),
+              bylen(this),
+              start(_start),
+              count(_count) {
+        }
+
+        ByStart bystart;
+        ByLen bylen;
+        uint32_t start;
+        uint32_t count;
+    };
+
 public:
+    struct Stats {
+        size_t goal_hits;
+        size_t best_fits;
+        size_t partial;
+    };
+
     explicit Allocator(const char *name, uint32_t first, uint32_t *first_free, uint32_t *free,
                        uint32_t total, uint32_t blocks);
+    ~Allocator();
+
+    /**
+     * Builds the index of free ranges from the bitmap
+     */
+    void load(Request &r);
 
     uint32_t alloc(Request &r) {
         size_t count = 1;
         return alloc(r, &count);
     }
-    uint32_t alloc(Request &r, size_t *count);
+    /**
+     * Allocates up to <count> consecutive blocks, starting at <goal> if it is free. Stores the
+     * number of allocated blocks in <count>, which might be less than requested.
+     */
+    uint32_t alloc(Request &r, size_t *count, uint32_t goal = 0);
     void free(Request &r, uint32_t start, size_t count);
 
+    size_t extents() const {
+        return _extents;
+    }
+    const Stats &stats() const {
+        return _stats;
+    }
+    void print_stats(m3::OStream &os) const;
+
 private:
+    void update_bitmap(Request &r, uint32_t start, size_t count, bool set);
+    void insert(FreeExtent *ext);
+    void remove(FreeExtent *ext);
+    void add_range(uint32_t start, uint32_t count);
+    void take_range(FreeExtent *ext, uint32_t start, uint32_t count);
+
     const char *_name;
     uint32_t _first;
     uint32_t *_first_free;
     uint32_t *_free;
     uint32_t _total;
     uint32_t _blocks;
+    size_t _extents;
+    m3::Treap<ByStart> _bystart;
+    m3::Treap<ByLen> _bylen;
+    Stats _stats;
 };
@@ -24,21 +24,130 @@ using namespace m3;
 
 static constexpr size_t BUF_SIZE = 64;
 
+static void put_entry(char *block, size_t blocksize, size_t *off, DirEntry **last,
+                      const DirEntry *e) {
+    DirEntry *ne = reinterpret_cast<DirEntry*>(block + *off);
+    ne->nodeno = e->nodeno;
+    ne->namelen = e->namelen;
+    // the last entry spans the rest of the block
+    ne->next = blocksize - *off;
+    memcpy(ne->name, e->name, e->namelen);
+    if(*last)
+        (*last)->next = static_cast<uint32_t>(reinterpret_cast<char*>(ne) - reinterpret_cast<char*>(*last));
+    *last = ne;
+    *off += sizeof(DirEntry) + e->namelen;
+}
+
+static void put_unused(char *block, size_t blocksize) {
+    DirEntry *e = reinterpret_cast<DirEntry*>(block);
+    e->nodeno = INVALID_INO;
+    e->namelen = 0;
+    e->next = blocksize;
+}
+
+DirEntry *Dirs::find_in_block(Request &r, blockno_t bno, const char *name, size_t namelen) {
+    foreach_direntry(r, bno, e) {
+        if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0)
+            return e;
+    }
+    r.pop_meta();
+    return nullptr;
+}
+
 DirEntry *Dirs::find_entry(Request &r, INode *inode, const char *name, size_t namelen) {
     size_t org_used = r.used_meta();
+    if(hashed(r, inode)) {
+        if(inode->size == 0)
+            return nullptr;
+        DirEntry *e = find_in_block(r, bucket(r, inode, name, namelen), name, namelen);
+        if(!e)
+            r.pop_meta(r.used_meta() - org_used);
+        return e;
+    }
+
     foreach_extent(r, inode, ext) {
         foreach_block(ext, bno) {
-            foreach_direntry(r, bno, e) {
-                if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0)
-                    return e;
-            }
-            r.pop_meta();
+            DirEntry *e = find_in_block(r, bno, name, namelen);
+            if(e)
+                return e;
         }
         r.pop_meta(r.used_meta() - org_used);
     }
     return nullptr;
 }
 
+static blockno_t get_block_no(Request &r, INode *dir, size_t no) {
+    size_t blocksize = r.hdl().sb().blocksize;
+    size_t off = no * blocksize;
+    size_t extent, extoff;
+    INodes::seek(r, dir, off, M3FS_SEEK_SET, extent, extoff);
+
+    Extent *indir = nullptr;
+    Extent *ext = INodes::get_extent(r, dir, extent, &indir, false);
+    assert(ext != nullptr && extoff / blocksize < ext->length);
+    return ext->start + extoff / blocksize;
+}
+
+blockno_t Dirs::bucket(Request &r, INode *dir, const char *name, size_t namelen) {
+    size_t blocks = dir->size / r.hdl().sb().blocksize;
+    return get_block_no(r, dir, dir_bucket(dir_hash(name, namelen), blocks));
+}
+
+Errors::Code Dirs::split(Request &r, INode *dir, size_t *from) {
+    size_t blocksize = r.hdl().sb().blocksize;
+    size_t blocks = dir->size / blocksize;
+    size_t org_used = r.used_meta();
+    *from = 0;
+
+    // append a block
+    Extent *indir = nullptr;
+    Extent *ext = INodes::get_extent(r, dir, dir->extents, &indir, true);
+    if(!ext)
+        return Errors::NO_SPACE;
+    INodes::fill_extent(r, dir, ext, 1, 1);
+    if(ext->length == 0)
+        return Errors::NO_SPACE;
+
+    char *nblock = reinterpret_cast<char*>(r.hdl().metabuffer().get_block(r, ext->start, true));
+    if(blocks == 0) {
+        put_unused(nblock, blocksize);
+        r.pop_meta(r.used_meta() - org_used);
+        return Errors::NONE;
+    }
+
+    // the first block that has not been split at this level yet
+    size_t low = 1;
+    while(low * 2 <= blocks)
+        low *= 2;
+    *from = blocks - low;
+    blockno_t obno = get_block_no(r, dir, *from);
+    char *oblock = reinterpret_cast<char*>(r.hdl().metabuffer().get_block(r, obno, true));
+
+    // we don't block from now on, so that a static buffer suffices
+    alignas(64) static char tmp[MAX_BLOCK_SIZE];
+    memcpy(tmp, oblock, blocksize);
+
+    size_t ooff = 0, noff = 0;
+    DirEntry *olast = nullptr, *nlast = nullptr;
+    DirEntry *e;
+    for(char *p = tmp; p < tmp + blocksize; p += e->next) {
+        e = reinterpret_cast<DirEntry*>(p);
+        if(e->namelen == 0)
+            continue;
+        if(dir_bucket(dir_hash(e->name, e->namelen), blocks + 1) == blocks)
+            put_entry(nblock, blocksize, &noff, &nlast, e);
+        else
+            put_entry(oblock, blocksize, &ooff, &olast, e);
+    }
+    if(!olast)
+        put_unused(oblock, blocksize);
+    if(!nlast)
+        put_unused(nblock, blocksize);
+
+    r.pop_meta(r.used_meta() - org_used);
+    return Errors::NONE;
+}
+
 inodeno_t Dirs::search(Request &r, const char *path, bool create) {
     while(*path == '/')
         path++;
@@ -46,39 +155,41 @@ inodeno_t Dirs::search(Request &r, const char *path, bool create) {
     if(*path == '\0')
         return 0;
 
-    INode *inode;
     const char *end;
     size_t namelen;
     inodeno_t ino = 0;
     size_t org_used = r.used_meta();
     while(1) {
-        inode = INodes::get(r, ino);
         // find path component end
         end = path;
         while(*end && *end != '/')
             end++;
 
         namelen = static_cast<size_t>(end - path);
-        DirEntry *e = find_entry(r, inode, path, namelen);
+        inodeno_t next;
+        if(!r.hdl().dentries().find(ino, path, namelen, &next)) {
+            // the lookup might block, so that others can change the directory meanwhile
+            size_t gen = r.hdl().dentries().generation();
+            INode *inode = INodes::get(r, ino);
+            DirEntry *e = M3FS_ISDIR(inode->mode) ? find_entry(r, inode, path, namelen) : nullptr;
+            next = e ? e->nodeno : INVALID_INO;
+            r.pop_meta(r.used_meta() - org_used);
+            r.hdl().dentries().insert_lookup(gen, ino, path, namelen, next);
+        }
+
         // in any case, skip trailing slashes (see if(create) ...)
         while(*end == '/')
             end++;
         // stop if the file doesn't exist
-        if(!e) {
-            r.pop_meta();
+        if(next == INVALID_INO)
             break;
-        }
         // if the path is empty, we're done
-        if(!*end) {
-            r.pop_meta(r.used_meta() - org_used);
-            return e->nodeno;
-        }
+        if(!*end)
+            return next;
 
         // to next layer
-        ino = e->nodeno;
+        ino = next;
         path = end;
-
-        r.pop_meta(r.used_meta() - org_used);
     }
 
     if(create) {
@@ -89,6 +200,7 @@ inodeno_t Dirs::search(Request &r, const char *path, bool create) {
         }
 
         // create inode and put a link into the directory
+        INode *inode = INodes::get(r, ino);
         INode *ninode = INodes::create(r, M3FS_IFREG | 0644);
         if(!ninode) {
             return INVALID_INO;
@@ -131,6 +243,8 @@ Errors::Code Dirs::create(Request &r, const char *path, mode_t mode) {
     INode *dirinode = INodes::create(r, M3FS_IFDIR | (mode & 0x777));
     if(dirinode == nullptr)
         return Errors::NO_SPACE;
+    if(r.hdl().sb().hashed_dirs())
+        dirinode->flags |= INODE_HASHED;
 
     // create directory itself
     Errors::Code res = Links::create(r, parinode, base, baselen, dirinode);
@@ -170,7 +284,8 @@ Errors::Code Dirs::remove(Request &r, const char *path) {
     foreach_extent(r, inode, ext) {
         foreach_block(ext, bno) {
             foreach_direntry(r, bno, e) {
-                if(!(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
+                if(e->namelen != 0 &&
+                   !(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
                    !(e->namelen == 2 && strncmp(e->name, "..", 2) == 0)) {
                     r.pop_meta(r.used_meta() - org_used);
                     return Errors::DIR_NOT_EMPTY;
@@ -185,7 +300,11 @@ Errors::Code Dirs::remove(Request &r, const char *path) {
     assert(inode->links == 2);
     // ensure that the inode is removed
     inode->links--;
-    return unlink(r, path, true);
+    Errors::Code res = unlink(r, path, true);
+    // the inode number might be reused, so that "." and ".." would be stale
+    if(res == Errors::NONE)
+        r.hdl().dentries().remove_dir(ino);
+    return res;
 }
 
 Errors::Code Dirs::link(Request &r, const char *oldpath, const char *newpath) {
@@ -33,8 +33,30 @@ class Dirs {
     Dirs() = delete;
 
     static m3::DirEntry *find_entry(Request &r, m3::INode *inode, const char *name, size_t namelen);
+    static m3::DirEntry *find_in_block(Request &r, m3::blockno_t bno, const char *name,
+                                       size_t namelen);
 
 public:
+    // the number of times the bucket of an entry is split to make room for it before the directory
+    // is no longer hashed. only names whose hashes collide need more than one split
+    static constexpr size_t MAX_SPLITS  = 4;
+
+    /**
+     * @return true if the entries of <dir> are placed by their hash (see m3::dir_bucket)
+     */
+    static bool hashed(Request &r, const m3::INode *dir) {
+        return r.hdl().sb().hashed_dirs() && (dir->flags & m3::INODE_HASHED);
+    }
+    /**
+     * @return the block of the hashed directory <dir> for the entry <name>
+     */
+    static m3::blockno_t bucket(Request &r, m3::INode *dir, const char *name, size_t namelen);
+    /**
+     * Appends a block to the hashed directory <dir> and moves the entries that belong into it
+     * from the block that is split next. The index of that block is stored in <from>.
+     */
+    static m3::Errors::Code split(Request &r, m3::INode *dir, size_t *from);
+
     static m3::inodeno_t search(Request &r, const char *path, bool create = false);
     static m3::Errors::Code create(Request &r, const char *path, m3::mode_t mode);
     static m3::Errors::Code remove(Request &r, const char *path);
@@ -65,6 +65,7 @@ void INodes::stat(Request &, const m3::INode *inode, FileInfo &info) {
     info.lastmod = inode->lastmod;
     info.extents = inode->extents;
     info.firstblock = inode->direct[0].start;
+    info.flags = inode->flags;
 }
 
 void INodes::mark_dirty(Request &r, inodeno_t ino) {
@@ -84,7 +85,8 @@ void INodes::sync_metadata(Request &r, INode *inode) {
 }
 
 size_t INodes::get_extent_mem(Request &r, INode *inode, size_t extent, size_t extoff, size_t *extlen,
-                              int perms, capsel_t sel, bool dirty, size_t accessed) {
+                              int perms, capsel_t sel, bool dirty, size_t accessed,
+                              File::Advice advice) {
     Extent *indir = nullptr;
     Extent *ext = get_extent(r, inode, extent, &indir, false);
     if(ext == nullptr || ext->length == 0)
@@ -93,7 +95,8 @@ size_t INodes::get_extent_mem(Request &r, INode *inode, size_t extent, size_t ex
     // create memory capability for extent
     uint32_t blocksize = r.hdl().sb().blocksize;
     *extlen = ext->length * blocksize;
-    size_t bytes = r.hdl().backend()->get_filedata(r, ext, extoff, perms, sel, dirty, true, accessed);
+    size_t bytes = r.hdl().backend()->get_filedata(r, ext, extoff, perms, sel, dirty, true, accessed,
+                                                  advice);
     if(bytes == 0)
         return 0;
 
@@ -109,7 +112,8 @@ size_t INodes::get_extent_mem(Request &r, INode *inode, size_t extent, size_t ex
 }
 
 size_t INodes::req_append(Request &r, INode *inode, size_t i, size_t extoff, size_t *extlen,
-                          capsel_t sel, int perm, Extent *ext, size_t accessed) {
+                          capsel_t sel, int perm, Extent *ext, uint32_t blocks, size_t accessed,
+                          File::Advice advice) {
     bool load = true;
     if(i < inode->extents) {
         Extent *indir = nullptr;
@@ -117,7 +121,10 @@ size_t INodes::req_append(Request &r, INode *inode, size_t i, size_t extoff, siz
         assert(ext != nullptr);
     }
     else {
-        fill_extent(r, nullptr, ext, r.hdl().extend(), accessed);
+        if(ext->length == 0)
+            fill_extent(r, nullptr, ext, blocks, accessed, alloc_goal(r, inode));
+        else if(r.hdl().clear_blocks())
+            r.hdl().backend()->clear_extent(r, ext, accessed);
         // this is a new extent we dont have to load it
         if(!r.hdl().clear_blocks())
             load = false;
@@ -127,7 +134,7 @@ size_t INodes::req_append(Request &r, INode *inode, size_t i, size_t extoff, siz
     }
 
     *extlen = ext->length * r.hdl().sb().blocksize;
-    return r.hdl().backend()->get_filedata(r, ext, extoff, perm, sel, true, load, accessed);
+    return r.hdl().backend()->get_filedata(r, ext, extoff, perm, sel, true, load, accessed, advice);
 }
 
 Errors::Code INodes::append_extent(Request &r, INode *inode, Extent *next, size_t *prev_ext_len) {
@@ -275,9 +282,26 @@ Extent *INodes::change_extent(Request &r, INode *inode, size_t i, Extent **indir
     return nullptr;
 }
 
-void INodes::fill_extent(Request &r, INode *inode, Extent *ext, uint32_t blocks, size_t accessed) {
+blockno_t INodes::alloc_goal(Request &r, INode *inode) {
+    // continue behind the last extent, so that append_extent can merge them
+    if(inode->extents == 0)
+        return 0;
+
+    size_t org_used = r.used_meta();
+    Extent *indir = nullptr;
+    Extent *ext = get_extent(r, inode, inode->extents - 1, &indir, false);
+    blockno_t goal = ext ? ext->start + ext->length : 0;
+    r.pop_meta(r.used_meta() - org_used);
+    return goal;
+}
+
+void INodes::fill_extent(Request &r, INode *inode, Extent *ext, uint32_t blocks, size_t accessed,
+                         blockno_t goal) {
+    if(inode && goal == 0)
+        goal = alloc_goal(r, inode);
+
     size_t count = blocks;
-    ext->start = r.hdl().blocks().alloc(r, &count);
+    ext->start = r.hdl().blocks().alloc(r, &count, goal);
     if(count == 0) {
         Errors::last = Errors::NO_SPACE;
         ext->length = 0;
@@ -330,8 +354,12 @@ size_t INodes::seek(Request &r, INode *inode, size_t &off, int whence, size_t &e
     if(off > inode->size)
         off = inode->size;
 
-    // now search until we've found the extent covering the desired file position
     size_t pos = 0;
+    if(inode->extents > ExtentCache::MIN_EXTENTS &&
+       r.hdl().extents().seek(r, inode, off, extent, extoff, &pos))
+        return pos;
+
+    // now search until we've found the extent covering the desired file position
     for(size_t i = 0; i < inode->extents; ++i) {
         Extent *ext = get_extent(r, inode, i, &indir, false);
         if(!ext)
@@ -353,6 +381,7 @@ size_t INodes::seek(Request &r, INode *inode, size_t &off, int whence, size_t &e
 
 void INodes::truncate(Request &r, INode *inode, size_t extent, size_t extoff) {
     uint32_t blocksize = r.hdl().sb().blocksize;
+    r.hdl().extents().invalidate(inode->inode);
 
     Extent *indir = nullptr;
     if(inode->extents > 0) {
@@ -20,6 +20,8 @@
 
 #include <fs/internal.h>
 
+#include <m3/vfs/File.h>
+
 #include "../sess/Request.h"
 
 /**
@@ -54,15 +56,23 @@ public:
                        size_t &extoff);
 
     static size_t get_extent_mem(Request &r, m3::INode *inode, size_t extent, size_t extoff,
-                                 size_t *extlen, int perms, capsel_t sel, bool dirty, size_t accessed);
+                                 size_t *extlen, int perms, capsel_t sel, bool dirty, size_t accessed,
+                                 m3::File::Advice advice = m3::File::NORMAL);
+    /**
+     * Requests memory to append to <inode>. If a new extent is needed, <ext> is used. It is either
+     * empty, so that <blocks> blocks are allocated for it, or holds blocks reserved before.
+     */
     static size_t req_append(Request &r, m3::INode *inode, size_t i, size_t extoff, size_t *extlen,
-                             capsel_t sel, int perm, m3::Extent *ext, size_t accessed);
+                             capsel_t sel, int perm, m3::Extent *ext, uint32_t blocks,
+                             size_t accessed, m3::File::Advice advice = m3::File::NORMAL);
     static m3::Errors::Code append_extent(Request &r, m3::INode *inode, m3::Extent *next,
                                           size_t *prev_ext_len);
 
     static m3::Extent *get_extent(Request &r, m3::INode *inode, size_t i, m3::Extent **indir, bool create);
     static m3::Extent *change_extent(Request &r, m3::INode *inode, size_t i, m3::Extent **indir, bool remove);
-    static void fill_extent(Request &r, m3::INode *inode, m3::Extent *ext, uint32_t blocks, size_t accessed);
+    static m3::blockno_t alloc_goal(Request &r, m3::INode *inode);
+    static void fill_extent(Request &r, m3::INode *inode, m3::Extent *ext, uint32_t blocks,
+                            size_t accessed, m3::blockno_t goal = 0);
 
     static void truncate(Request &r, m3::INode *inode, size_t extent, size_t extoff);
 
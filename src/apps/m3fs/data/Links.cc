@@ -20,28 +20,119 @@
 
 using namespace m3;
 
+static DirEntry *find_space(Request &r, blockno_t bno, size_t namelen, size_t *rem) {
+    foreach_direntry(r, bno, de) {
+        // reuse unused entries
+        if(de->namelen == 0 && de->next >= sizeof(DirEntry) + namelen) {
+            *rem = de->next;
+            r.hdl().metabuffer().mark_dirty(bno);
+            return de;
+        }
+
+        *rem = de->next - (sizeof(DirEntry) + de->namelen);
+        if(*rem >= sizeof(DirEntry) + namelen) {
+            // change previous entry
+            de->next = de->namelen + sizeof(DirEntry);
+            r.hdl().metabuffer().mark_dirty(bno);
+            // get pointer to new one
+            return reinterpret_cast<DirEntry*>(reinterpret_cast<uintptr_t>(de) + de->next);
+        }
+    }
+    r.pop_meta();
+    return nullptr;
+}
+
+static Errors::Code remove_from(Request &r, blockno_t bno, const char *name, size_t namelen,
+                                bool isdir) {
+    DirEntry *prev = nullptr;
+    foreach_direntry(r, bno, e) {
+        if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0) {
+            // if we're not removing a dir, we're coming from unlink(). in this case, directories
+            // are not allowed
+            INode *inode = INodes::get(r, e->nodeno);
+            if(!isdir && M3FS_ISDIR(inode->mode))
+                return Errors::IS_DIR;
+
+            // remove entry by skipping over it
+            if(prev)
+                prev->next += e->next;
+            // copy the next entry back, if there is any
+            else {
+                DirEntry *next = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(e) + e->next);
+                if(next < __eend) {
+                    size_t dist = e->next;
+                    memcpy(e, next, sizeof(DirEntry) + next->namelen);
+                    e->next = dist + next->next;
+                }
+                // otherwise, keep it as an unused entry
+                else {
+                    e->nodeno = INVALID_INO;
+                    e->namelen = 0;
+                }
+            }
+            r.hdl().metabuffer().mark_dirty(bno);
+
+            // reduce links and free, if necessary
+            if(--inode->links == 0)
+                r.hdl().files().delete_file(inode->inode);
+            return Errors::NONE;
+        }
+
+        prev = e;
+    }
+    r.pop_meta();
+    return Errors::NO_SUCH_FILE;
+}
+
 Errors::Code Links::create(Request &r, INode *dir, const char *name, size_t namelen, INode *inode) {
     size_t rem;
-    DirEntry *e;
+    DirEntry *e = nullptr;
 
     size_t org_used = r.used_meta();
-    foreach_extent(r, dir, ext) {
-        foreach_block(ext, bno) {
-            foreach_direntry(r, bno, de) {
-                rem = de->next - (sizeof(DirEntry) + de->namelen);
-                if(rem >= sizeof(DirEntry) + namelen) {
-                    // change previous entry
-                    de->next = de->namelen + sizeof(DirEntry);
-                    // get pointer to new one
-                    e = reinterpret_cast<DirEntry*>(reinterpret_cast<uintptr_t>(de) + de->next);
-                    r.hdl().metabuffer().mark_dirty(bno);
+    if(Dirs::hashed(r, dir)) {
+        uint32_t hash = dir_hash(name, namelen);
+        for(size_t splits = 0; ; ) {
+            size_t blocks = dir->size / r.hdl().sb().blocksize;
+            if(blocks > 0) {
+                e = find_space(r, Dirs::bucket(r, dir, name, namelen), namelen, &rem);
+                r.pop_meta(r.used_meta() - org_used);
+                if(e)
+                    goto found;
+            }
+
+            if(splits == Dirs::MAX_SPLITS) {
+                // the hash doesn't distribute these names; fall back to a linear directory
+                dir->flags &= static_cast<uint8_t>(~INODE_HASHED);
+                INodes::mark_dirty(r, dir->inode);
+                break;
+            }
+
+            // the blocks are split in order, not the full one. thus, split until the bucket of
+            // the entry has been split as well
+            size_t target = blocks > 0 ? dir_bucket(hash, blocks) : 0;
+            size_t from;
+            do {
+                Errors::Code res = Dirs::split(r, dir, &from);
+                if(res != Errors::NONE)
+                    return res;
+            }
+            while(blocks > 0 && from != target);
+            if(blocks > 0)
+                splits++;
+        }
+    }
+
+    {
+        foreach_extent(r, dir, ext) {
+            foreach_block(ext, bno) {
+                e = find_space(r, bno, namelen, &rem);
+                if(e) {
                     r.pop_meta(r.used_meta() - org_used);
                     goto found;
                 }
             }
-            r.pop_meta();
+            r.pop_meta(r.used_meta() - org_used);
         }
-        r.pop_meta(r.used_meta() - org_used);
     }
 
     // no suitable space found; extend directory
@@ -70,48 +161,31 @@ found:
 
     inode->links++;
     INodes::mark_dirty(r, inode->inode);
+    r.hdl().dentries().insert(dir->inode, name, namelen, inode->inode);
     return Errors::NONE;
 }
 
 Errors::Code Links::remove(Request &r, INode *dir, const char *name, size_t namelen, bool isdir) {
     size_t org_used = r.used_meta();
+    if(Dirs::hashed(r, dir)) {
+        Errors::Code res = Errors::NO_SUCH_FILE;
+        if(dir->size > 0)
+            res = remove_from(r, Dirs::bucket(r, dir, name, namelen), name, namelen, isdir);
+        r.pop_meta(r.used_meta() - org_used);
+        if(res == Errors::NONE)
+            r.hdl().dentries().insert(dir->inode, name, namelen, INVALID_INO);
+        return res;
+    }
+
     foreach_extent(r, dir, ext) {
         foreach_block(ext, bno) {
-            DirEntry *prev = nullptr;
-            foreach_direntry(r, bno, e) {
-                if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0) {
-                    // if we're not removing a dir, we're coming from unlink(). in this case, directories
-                    // are not allowed
-                    INode *inode = INodes::get(r, e->nodeno);
-                    if(!isdir && M3FS_ISDIR(inode->mode)) {
-                        r.pop_meta(r.used_meta() - org_used);
-                        return Errors::IS_DIR;
-                    }
-
-                    // remove entry by skipping over it
-                    if(prev)
-                        prev->next += e->next;
-                    // copy the next entry back, if there is any
-                    else {
-                        DirEntry *next = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(e) + e->next);
-                        if(next < __eend) {
-                            size_t dist = e->next;
-                            memcpy(e, next, sizeof(DirEntry) + next->namelen);
-                            e->next = dist + next->next;
-                        }
-                    }
-                    r.hdl().metabuffer().mark_dirty(bno);
-
-                    // reduce links and free, if necessary
-                    if(--inode->links == 0)
-                        r.hdl().files().delete_file(inode->inode);
-                    r.pop_meta(r.used_meta() - org_used);
-                    return Errors::NONE;
-                }
-
-                prev = e;
+            Errors::Code res = remove_from(r, bno, name, namelen, isdir);
+            if(res != Errors::NO_SUCH_FILE) {
+                r.pop_meta(r.used_meta() - org_used);
+                if(res == Errors::NONE)
+                    r.hdl().dentries().insert(dir->inode, name, namelen, INVALID_INO);
+                return res;
             }
-            r.pop_meta();
         }
         r.pop_meta(r.used_meta() - org_used);
     }
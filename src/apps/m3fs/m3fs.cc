@@ -36,6 +36,7 @@
 #include "sess/FileSession.h"
 #include "sess/MetaSession.h"
 #include "FSHandle.h"
+#include "WriteBack.h"
 
 // TODO remove workloop; do it like in rust
 
@@ -52,11 +53,13 @@ static Server<M3FSRequestHandler> *srv;
 class M3FSRequestHandler : public base_class {
 public:
     explicit M3FSRequestHandler(Backend *backend, size_t extend, bool clear,
-                                bool revoke_first, size_t max_load)
+                                bool revoke_first, size_t max_load, size_t fbsize, size_t mbsize,
+                                size_t wbhigh)
         : base_class(),
           _rgate(RecvGate::create(nextlog2<32 * M3FSSession::MSG_SIZE>::val,
                                   nextlog2<M3FSSession::MSG_SIZE>::val)),
-          _handle(backend, extend, clear, revoke_first, max_load) {
+          _handle(backend, extend, clear, revoke_first, max_load, fbsize, mbsize),
+          _writeback(_handle, wbhigh) {
         add_operation(M3FS::OPEN_PRIV, &M3FSRequestHandler::open_private_file);
         add_operation(M3FS::CLOSE_PRIV, &M3FSRequestHandler::close_private_file);
         add_operation(M3FS::NEXT_IN, &M3FSRequestHandler::next_in);
@@ -64,14 +67,16 @@ public:
         add_operation(M3FS::COMMIT, &M3FSRequestHandler::commit);
         add_operation(M3FS::FSTAT, &M3FSRequestHandler::fstat);
         add_operation(M3FS::SEEK, &M3FSRequestHandler::seek);
+        add_operation(M3FS::LOCATE, &M3FSRequestHandler::locate);
+        add_operation(M3FS::READDIR, &M3FSRequestHandler::readdir);
+        add_operation(M3FS::ADVISE, &M3FSRequestHandler::advise);
         add_operation(M3FS::STAT, &M3FSRequestHandler::stat);
         add_operation(M3FS::MKDIR, &M3FSRequestHandler::mkdir);
         add_operation(M3FS::RMDIR, &M3FSRequestHandler::rmdir);
         add_operation(M3FS::LINK, &M3FSRequestHandler::link);
         add_operation(M3FS::UNLINK, &M3FSRequestHandler::unlink);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&M3FSRequestHandler::handle_message, this, _1));
+        _rgate.start<base_class, &base_class::handle_message>(this);
     }
 
     virtual Errors::Code open(M3FSSession **sess, capsel_t srv_sel, word_t) override {
@@ -90,25 +95,29 @@ public:
             auto file = static_cast<M3FSFileSession *>(sess);
             if(data.args.count == 0)
                 return file->clone(srv->sel(), data);
+            // two arguments request a window of extents for sequential reading
+            if(data.args.count == 2)
+                return file->get_window(data);
             return file->get_mem(data);
         }
     }
 
     virtual Errors::Code delegate(M3FSSession *sess, KIF::Service::ExchangeData &data) override {
-        if(data.args.count != 0)
-            return Errors::NOT_SUP;
-
         if(sess->type() == M3FSSession::META) {
+            if(data.args.count != 0)
+                return Errors::NOT_SUP;
             capsel_t sels = VPE::self().alloc_sels(data.caps);
             static_cast<M3FSMetaSession *>(sess)->set_eps(sels, data.caps);
             data.caps = KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sels, data.caps).value();
             return Errors::NONE;
         }
         else {
-            if(data.caps != 1)
+            // the optional argument denotes the EP index (1 = read-ahead EP)
+            size_t idx = data.args.count == 1 ? static_cast<size_t>(data.args.vals[0]) : 0;
+            if(data.caps != 1 || data.args.count > 1 || idx >= M3FSFileSession::MAX_CLIENT_EPS)
                 return Errors::NOT_SUP;
             capsel_t sel = VPE::self().alloc_sel();
-            static_cast<M3FSFileSession *>(sess)->set_ep(sel);
+            static_cast<M3FSFileSession *>(sess)->set_ep(sel, idx);
             data.caps = KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sel, data.caps).value();
             return Errors::NONE;
         }
@@ -120,8 +129,33 @@ public:
         return Errors::NONE;
     }
 
+    WriteBack &writeback() {
+        return _writeback;
+    }
+    Prefetcher &prefetcher() {
+        return _handle.prefetcher();
+    }
+
     virtual void shutdown() override {
         _rgate.stop();
+        env()->workloop()->remove(&_writeback);
+        env()->workloop()->remove(&_handle.prefetcher());
+        // both might be blocked on the disk; let them finish before we flush the buffers
+        _writeback.wait();
+        _handle.prefetcher().wait();
+        if(ServiceLog::level & ServiceLog::FS) {
+            _writeback.print_stats(Serial::get());
+            _handle.prefetcher().print_stats(Serial::get());
+            _handle.dentries().print_stats(Serial::get());
+            _handle.extents().print_stats(Serial::get());
+            _handle.blocks().print_stats(Serial::get());
+            _handle.inodes().print_stats(Serial::get());
+        }
+        // the blocks reserved for appends are allocated in the bitmap; give them back
+        {
+            Request r(_handle);
+            _handle.files().release_all(r);
+        }
         _handle.flush_buffer();
         _handle.shutdown();
     }
@@ -161,6 +195,21 @@ public:
         sess->fstat(is);
     }
 
+    void locate(GateIStream &is) {
+        M3FSSession *sess = is.label<M3FSSession *>();
+        sess->locate(is);
+    }
+
+    void readdir(GateIStream &is) {
+        M3FSSession *sess = is.label<M3FSSession *>();
+        sess->readdir(is);
+    }
+
+    void advise(GateIStream &is) {
+        M3FSSession *sess = is.label<M3FSSession *>();
+        sess->advise(is);
+    }
+
     void stat(GateIStream &is) {
         M3FSSession *sess = is.label<M3FSSession *>();
         sess->stat(is);
@@ -190,19 +239,25 @@ private:
     RecvGate _rgate;
     //MemGate _mem;
     FSHandle _handle;
+    WriteBack _writeback;
 };
 
 NORETURN static void usage(const char *name) {
     cerr << "Usage: " << name
          << " [-n <name>] [-s <sel>] [-e <blocks>] [-c] [-r] [-b <blocks>]\n"
-         << " [-o <offset>] (disk <dev>|mem <fssize>)\n";
+         << " [-f <blocks>] [-m <blocks>] [-w <blocks>] [-o <offset>] [-p <sessions>] (disk <dev>|mem <fssize>)\n";
     cerr << "  -n: the name of the service (m3fs by default)\n";
     cerr << "  -s: don't create service, use selectors <sel>..<sel+1>\n";
     cerr << "  -e: the number of blocks to extend files when appending\n";
     cerr << "  -c: clear allocated blocks\n";
     cerr << "  -r: revoke first, reply afterwards\n";
     cerr << "  -b: the maximum number of blocks loaded from the disk\n";
+    cerr << "  -f: the size of the file buffer in blocks (" << FileBuffer::DEF_SIZE << " by default)\n";
+    cerr << "  -m: the size of the meta buffer in blocks (" << MetaBuffer::DEF_SIZE << " by default)\n";
+    cerr << "  -w: the number of dirty blocks to start the write-back at (0 = disabled,\n";
+    cerr << "      a quarter of the file buffer by default)\n";
     cerr << "  -o: the file system offset in DRAM\n";
+    cerr << "  -p: the number of sessions to create in advance for fast session opens\n";
     exit(1);
 }
 
@@ -210,14 +265,18 @@ int main(int argc, char *argv[]) {
     const char *name  = "m3fs";
     size_t extend     = 128;
     size_t max_load   = 128;
+    size_t fbsize     = FileBuffer::DEF_SIZE;
+    size_t mbsize     = MetaBuffer::DEF_SIZE;
+    size_t wbhigh     = static_cast<size_t>(-1);
     bool clear        = false;
     bool revoke_first = false;
     capsel_t sels     = ObjCap::INVALID;
     epid_t ep         = EP_COUNT;
     goff_t fs_offset  = FS_IMG_OFFSET;
+    size_t presess    = 0;
 
     int opt;
-    while((opt = CmdArgs::get(argc, argv, "n:s:e:crb:o:")) != -1) {
+    while((opt = CmdArgs::get(argc, argv, "n:s:e:crb:f:m:w:o:p:")) != -1) {
         switch(opt) {
             case 'n': name = CmdArgs::arg; break;
             case 's': {
@@ -230,12 +289,18 @@ int main(int argc, char *argv[]) {
             case 'c': clear = true; break;
             case 'r': revoke_first = true; break;
             case 'b': max_load = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'f': fbsize = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'm': mbsize = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'w': wbhigh = IStringStream::read_from<size_t>(CmdArgs::arg); break;
             case 'o': fs_offset = IStringStream::read_from<goff_t>(CmdArgs::arg); break;
+            case 'p': presess = IStringStream::read_from<size_t>(CmdArgs::arg); break;
             default: usage(argv[0]);
         }
     }
     if(CmdArgs::ind + 1 >= argc)
         usage(argv[0]);
+    if(wbhigh == static_cast<size_t>(-1))
+        wbhigh = fbsize / 4;
 
     // create backend
     Backend *backend;
@@ -251,12 +316,24 @@ int main(int argc, char *argv[]) {
     else
         usage(argv[0]);
 
-    auto hdl    = new M3FSRequestHandler(backend, extend, clear, revoke_first, max_load);
+    auto hdl    = new M3FSRequestHandler(backend, extend, clear, revoke_first, max_load, fbsize,
+                                         mbsize, wbhigh);
     if(sels != ObjCap::INVALID)
         srv = new Server<M3FSRequestHandler>(sels, ep, hdl);
     else
         srv = new Server<M3FSRequestHandler>(name, hdl);
 
+    // this is fine, because our sessions don't depend on the argument of open
+    if(presess > 0) {
+        Errors::Code res = srv->prepare_sessions(presess);
+        if(res != Errors::NONE)
+            cerr << "Unable to prepare sessions: " << Errors::to_string(res) << "\n";
+    }
+
+    if(wbhigh > 0)
+        env()->workloop()->add(&hdl->writeback(), true);
+    env()->workloop()->add(&hdl->prefetcher(), true);
+
     env()->workloop()->multithreaded(16);
     env()->workloop()->run();
 
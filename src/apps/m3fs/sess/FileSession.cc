@@ -23,6 +23,7 @@
 #include <m3/session/M3FS.h>
 
 #include "../FSHandle.h"
+#include "../data/Dirs.h"
 #include "../data/INodes.h"
 #include "MetaSession.h"
 
@@ -39,11 +40,18 @@ M3FSFileSession::M3FSFileSession(FSHandle &handle, capsel_t srv_sel, M3FSMetaSes
       _fileoff(),
       _lastbytes(),
       _accessed(),
+      _advice(File::NORMAL),
+      _seqreads(),
       _moved_forward(false),
       _appending(),
       _append_ext(),
-      _last(ObjCap::INVALID),
-      _epcap(ObjCap::INVALID),
+      _wr_bno(),
+      _wr_capoff(),
+      _wr_blocks(),
+      _last{ObjCap::INVALID, ObjCap::INVALID},
+      _epcap{ObjCap::INVALID, ObjCap::INVALID},
+      _win(ObjCap::INVALID),
+      _wincount(),
       _sgate(srv_sel == ObjCap::INVALID
         ? nullptr
         : new m3::SendGate(m3::SendGate::create(&meta->rgate(), reinterpret_cast<label_t>(this),
@@ -71,8 +79,12 @@ M3FSFileSession::~M3FSFileSession() {
     hdl().files().rem_sess(this);
     _meta->remove_file(this);
 
-    if(_last != ObjCap::INVALID)
-        VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last, 1));
+    for(size_t i = 0; i < MAX_CLIENT_EPS; ++i) {
+        if(_last[i] != ObjCap::INVALID)
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last[i], 1));
+    }
+    if(_wincount > 0)
+        VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _win, _wincount));
 }
 
 Errors::Code M3FSFileSession::clone(capsel_t srv, KIF::Service::ExchangeData &data) {
@@ -132,8 +144,94 @@ Errors::Code M3FSFileSession::get_mem(KIF::Service::ExchangeData &data) {
     return Errors::NONE;
 }
 
+Errors::Code M3FSFileSession::get_window(KIF::Service::ExchangeData &data) {
+    EVENT_TRACER_FS_getlocs();
+    size_t offset = data.args.vals[0];
+    size_t count = Math::min(static_cast<size_t>(data.args.vals[1]),
+                             Math::min(static_cast<size_t>(data.caps), MAX_WINDOW_EXTS));
+
+    PRINT(this, "file::get_window(path=" << _filename << ", offset=" << offset
+                                         << ", count=" << count << ")");
+
+    // windows are only handed out for reading; writes need the commits of next_out
+    if(!(_oflags & FILE_R) || (_oflags & FILE_W))
+        return Errors::NO_PERM;
+    if(count == 0 || _appending)
+        return Errors::INV_ARGS;
+
+    Request r(hdl());
+    INode *inode = INodes::get(r, _ino);
+    assert(inode != nullptr);
+
+    // see seek()
+    _wr_blocks = 0;
+    _seqreads = offset == _fileoff ? _seqreads + 1 : 0;
+
+    if(_accessed < 31)
+        _accessed++;
+
+    // the client has moved on from the last window
+    if(_wincount > 0) {
+        VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _win, _wincount));
+        _wincount = 0;
+    }
+    if(_win == ObjCap::INVALID)
+        _win = VPE::self().alloc_sels(MAX_WINDOW_EXTS);
+
+    size_t n = 0;
+    size_t total = 0;
+    size_t extent = 0, extoff = 0;
+    size_t pos = offset;
+    INodes::seek(r, inode, pos, M3FS_SEEK_SET, extent, extoff);
+    data.args.vals[0] = extoff % hdl().sb().blocksize;
+    for(; n < count && offset + total < inode->size; ++n) {
+        size_t extlen = 0;
+        Errors::last = Errors::NONE;
+        size_t len = INodes::get_extent_mem(r, inode, extent, extoff, &extlen,
+                                            _oflags & MemGate::RWX, _win + n, false, _accessed,
+                                            _advice);
+        if(Errors::occurred() || len == 0)
+            break;
+
+        // the same as in next_in_out: the cap starts at the block containing <extoff>
+        size_t capoff = extoff % hdl().sb().blocksize;
+        data.args.vals[1 + n] = len - capoff;
+        total += len - capoff;
+        if(extoff + len >= extlen) {
+            extent += 1;
+            extoff = 0;
+        }
+        else
+            extoff += len - capoff;
+    }
+    if(n == 0 && Errors::occurred()) {
+        PRINT(this, "getting extent memory failed: " << Errors::to_string(Errors::last));
+        return Errors::last;
+    }
+    _wincount = n;
+
+    // continue behind the window
+    _extent = extent;
+    _extoff = extoff;
+    _fileoff = offset + total;
+    _lastbytes = 0;
+    prefetch_next(r, inode);
+
+    data.caps = KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _win, n).value();
+    data.args.count = 1 + n;
+
+    PRINT(this, "file::get_window -> (" << data.args.vals[0] << ", " << n << " extents, "
+                                        << total << " bytes)");
+    return Errors::NONE;
+}
+
 void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
-    PRINT(this, "file::next_" << (out ? "out" : "in") << "(); "
+    // clients that use read-ahead tell us which of their EPs should receive the memory cap
+    size_t epidx = 0;
+    if(is.remaining() > 0)
+        is >> epidx;
+
+    PRINT(this, "file::next_" << (out ? "out" : "in") << "(ep=" << epidx << "); "
                               << "file[path=" << _filename << ", fileoff=" << _fileoff << ", ext=" << _extent
                               << ", extoff=" << _extoff << "]");
 
@@ -141,12 +239,18 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
         reply_error(is, Errors::NO_PERM);
         return;
     }
+    if(epidx >= MAX_CLIENT_EPS) {
+        reply_error(is, Errors::INV_ARGS);
+        return;
+    }
 
     Request r(hdl());
     INode *inode = INodes::get(r, _ino);
     assert(inode != nullptr);
 
     // in/out implicitly commits the previous in/out request
+    commit_write(r, _lastbytes);
+    _seqreads = out ? 0 : _seqreads + 1;
     if(out && _appending) {
         Errors::Code res = commit(r, inode, _lastbytes);
         if(res != Errors::NONE) {
@@ -179,11 +283,23 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
             _fileoff = INodes::seek(r, inode, off, M3FS_SEEK_END, _extent, _extoff);
         }
 
+        // if we need a new extent, take the blocks that were left over from the last append
         Extent e = {0, 0};
+        if(_extent >= inode->extents)
+            e = hdl().files().take_reserved(of);
+        uint32_t blocks = static_cast<uint32_t>(hdl().files().prealloc_blocks(of));
         len = INodes::req_append(r, inode, _extent, _extoff, &extlen, sel,
-                                 _oflags & MemGate::RWX, &e, _accessed);
+                                 _oflags & MemGate::RWX, &e, blocks, _accessed, _advice);
+        // if the disk is full, try again without the blocks reserved for other files
+        if(Errors::last == Errors::NO_SPACE && hdl().files().release_all(r) > 0) {
+            Errors::last = Errors::NONE;
+            len = INodes::req_append(r, inode, _extent, _extoff, &extlen, sel,
+                                     _oflags & MemGate::RWX, &e, blocks, _accessed, _advice);
+        }
         if(Errors::occurred()) {
             PRINT(this, "append failed: " << Errors::to_string(Errors::last));
+            if(e.length > 0)
+                hdl().blocks().free(r, e.start, e.length);
             reply_error(is, Errors::last);
             return;
         }
@@ -195,7 +311,7 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
     else {
         // get next mem cap
         len = INodes::get_extent_mem(r, inode, _extent, _extoff, &extlen,
-                                     _oflags & MemGate::RWX, sel, out, _accessed);
+                                     _oflags & MemGate::RWX, sel, out, _accessed, _advice);
         if(Errors::occurred()) {
             PRINT(this, "getting extent memory failed: " << Errors::to_string(Errors::last));
             reply_error(is, Errors::last);
@@ -209,9 +325,17 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
     size_t capoff = _lastoff % hdl().sb().blocksize;
     _extlen = extlen;
     _lastbytes = len - capoff;
+    if(out && len > 0) {
+        uint32_t blocksize = hdl().sb().blocksize;
+        Extent *indir = nullptr;
+        Extent *ext = _append_ext ? _append_ext : INodes::get_extent(r, inode, _extent, &indir, false);
+        _wr_bno = ext->start + (_append_ext ? 0 : _lastoff / blocksize);
+        _wr_capoff = capoff;
+        _wr_blocks = (len + blocksize - 1) / blocksize;
+    }
     if(len > 0) {
         // activate mem cap for client
-        if(Syscalls::get().activate(_epcap, sel, 0) != Errors::NONE) {
+        if(Syscalls::get().activate(_epcap[epidx], sel, 0) != Errors::NONE) {
             PRINT(this, "activate failed: " << Errors::to_string(Errors::last));
             reply_error(is, Errors::last);
             return;
@@ -228,6 +352,8 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
             _moved_forward = false;
         }
         _fileoff += len - capoff;
+        if(!out)
+            prefetch_next(r, inode);
     }
     else {
         capoff = _lastoff = 0;
@@ -239,18 +365,18 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
 
     if(hdl().revoke_first()) {
         // revoke last mem cap and remember new one
-        if(_last != ObjCap::INVALID)
-            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last, 1));
-        _last = sel;
+        if(_last[epidx] != ObjCap::INVALID)
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last[epidx], 1));
+        _last[epidx] = sel;
 
         reply_vmsg(is, Errors::NONE, capoff, _lastbytes);
     }
     else {
         reply_vmsg(is, Errors::NONE, capoff, _lastbytes);
 
-        if(_last != ObjCap::INVALID)
-            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last, 1));
-        _last = sel;
+        if(_last[epidx] != ObjCap::INVALID)
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last[epidx], 1));
+        _last[epidx] = sel;
     }
 }
 
@@ -266,20 +392,29 @@ void M3FSFileSession::commit(GateIStream &is) {
     size_t nbytes;
     is >> nbytes;
 
+    size_t filesize;
+    Errors::Code res = commit_bytes(nbytes, &filesize);
+    if(res != Errors::NONE)
+        reply_error(is, res);
+    else
+        reply_vmsg(is, Errors::NONE, filesize);
+}
+
+Errors::Code M3FSFileSession::commit_bytes(size_t nbytes, size_t *filesize) {
     Request r(hdl());
 
     PRINT(this, "file::commit(nbytes=" << nbytes << "); "
                                        << "file[path=" << _filename << ", fileoff=" << _fileoff
                                        << ", ext=" << _extent << ", extoff=" << _extoff << "]");
 
-    if(nbytes == 0 || nbytes > _lastbytes) {
-        reply_error(is, Errors::INV_ARGS);
-        return;
-    }
+    if(nbytes == 0 || nbytes > _lastbytes)
+        return Errors::INV_ARGS;
 
     INode *inode = INodes::get(r, _ino);
     assert(inode != nullptr);
 
+    commit_write(r, nbytes);
+
     Errors::Code res;
     if(_appending)
         res = commit(r, inode, nbytes);
@@ -292,7 +427,8 @@ void M3FSFileSession::commit(GateIStream &is) {
     }
     _lastbytes = 0;
 
-    reply_vmsg(is, res, inode->size);
+    *filesize = inode->size;
+    return res;
 }
 
 void M3FSFileSession::seek(GateIStream &is) {
@@ -312,12 +448,275 @@ void M3FSFileSession::seek(GateIStream &is) {
     INode *inode = INodes::get(r, _ino);
     assert(inode != nullptr);
 
+    // without a commit, we don't know what has been written; keep all blocks pending
+    _wr_blocks = 0;
+    _seqreads = 0;
+
     size_t pos = INodes::seek(r, inode, off, whence, _extent, _extoff);
     _fileoff = pos + off;
 
     reply_vmsg(is, Errors::NONE, pos, off);
 }
 
+void M3FSFileSession::locate(GateIStream &is) {
+    size_t offset, cur;
+    bool out;
+    is >> offset >> out >> cur;
+
+    Request r(hdl());
+
+    PRINT(this, "file::locate(path=" << _filename << ", off=" << offset << ", out=" << out
+                                     << ", cur=" << cur << ")");
+
+    if((out && !(_oflags & FILE_W)) || (!out && !(_oflags & FILE_R))) {
+        reply_error(is, Errors::NO_PERM);
+        return;
+    }
+    // the client has to commit the appended data first
+    if(_appending) {
+        reply_error(is, Errors::INV_ARGS);
+        return;
+    }
+
+    INode *inode = INodes::get(r, _ino);
+    assert(inode != nullptr);
+
+    if(_accessed < 31)
+        _accessed++;
+
+    // positional accesses never extend the file
+    size_t capoff = 0, len = 0;
+    capsel_t sel = ObjCap::INVALID;
+    if(offset < inode->size) {
+        size_t extent, extoff;
+        INodes::seek(r, inode, offset, M3FS_SEEK_SET, extent, extoff);
+
+        sel = VPE::self().alloc_sel();
+        size_t extlen = 0;
+        Errors::last = Errors::NONE;
+        len = INodes::get_extent_mem(r, inode, extent, extoff, &extlen,
+                                     _oflags & MemGate::RWX, sel, out, _accessed, _advice);
+        if(Errors::occurred()) {
+            PRINT(this, "getting extent memory failed: " << Errors::to_string(Errors::last));
+            reply_error(is, Errors::last);
+            return;
+        }
+
+        capoff = extoff % hdl().sb().blocksize;
+        if(len > 0) {
+            if(Syscalls::get().activate(_epcap[0], sel, 0) != Errors::NONE) {
+                PRINT(this, "activate failed: " << Errors::to_string(Errors::last));
+                reply_error(is, Errors::last);
+                return;
+            }
+            len -= capoff;
+        }
+        else {
+            capoff = 0;
+            sel = ObjCap::INVALID;
+        }
+    }
+
+    // the client's EP no longer covers the current position. thus, continue at <cur> afterwards
+    size_t pos = INodes::seek(r, inode, cur, M3FS_SEEK_SET, _extent, _extoff);
+    _fileoff = pos + cur;
+    _lastbytes = 0;
+    _seqreads = 0;
+
+    PRINT(this, "file::locate() -> (" << capoff << ", " << len << ")");
+
+    reply_vmsg(is, Errors::NONE, capoff, len);
+
+    if(sel != ObjCap::INVALID) {
+        if(_last[0] != ObjCap::INVALID)
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last[0], 1));
+        _last[0] = sel;
+    }
+}
+
+void M3FSFileSession::readdir(GateIStream &is) {
+    size_t off, max;
+    bool attrs;
+    is >> off >> attrs >> max;
+
+    Request r(hdl());
+
+    PRINT(this, "file::readdir(path=" << _filename << ", off=" << off << ", attrs=" << attrs << ")");
+
+    if(!(_oflags & FILE_R)) {
+        reply_error(is, Errors::NO_PERM);
+        return;
+    }
+
+    INode *inode = INodes::get(r, _ino);
+    assert(inode != nullptr);
+    if(!M3FS_ISDIR(inode->mode)) {
+        reply_error(is, Errors::IS_NO_DIR);
+        return;
+    }
+
+    // the error, the number of entries and the next offset precede the entries
+    if(max < 3 * sizeof(xfer_t)) {
+        reply_error(is, Errors::INV_ARGS);
+        return;
+    }
+    size_t space = Math::min(max, M3FS::READDIR_MSG_SIZE) - 3 * sizeof(xfer_t);
+
+    // each entry needs at least 4 words; the entries are copied out of the directory, because
+    // loading their inodes for the attributes might block and the directory might change meanwhile
+    static const size_t MAX_ENTRIES = M3FS::READDIR_MSG_SIZE / (4 * sizeof(xfer_t));
+    struct {
+        inodeno_t nodeno;
+        size_t next;
+        String name;
+    } found[MAX_ENTRIES];
+    size_t count = 0;
+    size_t next = off;
+    bool full = false;
+
+    uint32_t blocksize = hdl().sb().blocksize;
+    size_t blockoff = 0;
+    size_t org_used = r.used_meta();
+    foreach_extent(r, inode, ext) {
+        foreach_block(ext, bno) {
+            if(!full && blockoff + blocksize > off) {
+                char *start = reinterpret_cast<char*>(hdl().metabuffer().get_block(r, bno));
+                DirEntry *e;
+                for(char *p = start; p < start + blocksize; p += e->next) {
+                    e = reinterpret_cast<DirEntry*>(p);
+                    size_t eoff = blockoff + static_cast<size_t>(p - start);
+                    if(eoff < off)
+                        continue;
+                    // skip unused entries, but let the client continue behind them
+                    if(e->namelen == 0) {
+                        next = eoff + e->next;
+                        continue;
+                    }
+
+                    // nodeno, the offset behind the entry, name and the optional attributes
+                    size_t size = 3 * sizeof(xfer_t) + Math::round_up<size_t>(e->namelen, sizeof(xfer_t));
+                    if(attrs)
+                        size += OStreamSize<FileInfo>::value;
+                    if(size > space) {
+                        full = true;
+                        break;
+                    }
+
+                    found[count].nodeno = e->nodeno;
+                    found[count].next = eoff + e->next;
+                    found[count].name.reset(e->name, e->namelen);
+                    space -= size;
+                    next = eoff + e->next;
+                    count++;
+                }
+                r.pop_meta();
+            }
+            blockoff += blocksize;
+        }
+        r.pop_meta(r.used_meta() - org_used);
+        if(full)
+            break;
+    }
+
+    // not even a single entry fits into the reply
+    if(full && count == 0) {
+        reply_error(is, Errors::NO_SPACE);
+        return;
+    }
+
+    StaticGateOStream<M3FS::READDIR_MSG_SIZE> entries;
+    for(size_t i = 0; i < count; ++i) {
+        entries << found[i].nodeno << found[i].next << found[i].name;
+        if(attrs) {
+            FileInfo info;
+            INodes::stat(r, INodes::get(r, found[i].nodeno), info);
+            r.pop_meta();
+            entries << info;
+        }
+    }
+
+    PRINT(this, "file::readdir() -> (" << count << " entries, next=" << next << ")");
+
+    StaticGateOStream<M3FS::READDIR_MSG_SIZE> reply;
+    reply << Errors::NONE << count << next;
+    reply.put(entries);
+    is.reply(reply);
+}
+
+void M3FSFileSession::advise(GateIStream &is) {
+    size_t off, len;
+    File::Advice advice;
+    is >> off >> len >> advice;
+
+    PRINT(this, "file::advise(path=" << _filename << ", off=" << off << ", len=" << len
+                                     << ", advice=" << advice << ")");
+
+    switch(advice) {
+        // the access pattern is remembered for the whole file, regardless of the range
+        case File::NORMAL:
+        case File::SEQUENTIAL:
+        case File::RANDOM:
+        case File::NOREUSE:
+            _advice = advice;
+            break;
+
+        case File::WILLNEED:
+        case File::DONTNEED: {
+            Request r(hdl());
+            INode *inode = INodes::get(r, _ino);
+            assert(inode != nullptr);
+            prefetch_or_drop(r, inode, off, len, advice == File::WILLNEED);
+            break;
+        }
+
+        default:
+            reply_error(is, Errors::INV_ARGS);
+            return;
+    }
+
+    reply_vmsg(is, Errors::NONE);
+}
+
+void M3FSFileSession::prefetch_or_drop(Request &r, INode *inode, size_t off, size_t len,
+                                       bool prefetch) {
+    size_t end = (len == 0 || off + len > inode->size) ? inode->size : off + len;
+    if(off >= end)
+        return;
+
+    size_t extent, extoff;
+    size_t extpos = INodes::seek(r, inode, off, M3FS_SEEK_SET, extent, extoff);
+    size_t cur = extpos + extoff;
+    uint32_t blocksize = hdl().sb().blocksize;
+
+    // the caps are only used to load the blocks into the file buffer
+    capsel_t sel = prefetch ? VPE::self().alloc_sel() : ObjCap::INVALID;
+    for(; cur < end && extent < inode->extents; ++extent, extoff = 0) {
+        Extent *indir = nullptr;
+        Extent *ext = INodes::get_extent(r, inode, extent, &indir, false);
+        if(!ext)
+            break;
+
+        size_t extbytes = ext->length * blocksize;
+        if(!prefetch) {
+            hdl().backend()->drop_filedata(r, ext, extoff, end - cur);
+            cur += extbytes - extoff;
+            continue;
+        }
+
+        while(extoff < extbytes && cur < end) {
+            size_t bytes = hdl().backend()->get_filedata(r, ext, extoff, MemGate::R, sel, false, true,
+                                                         _accessed, File::SEQUENTIAL);
+            if(bytes == 0)
+                return;
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sel, 1));
+
+            size_t amount = bytes - extoff % blocksize;
+            extoff += amount;
+            cur += amount;
+        }
+    }
+}
+
 void M3FSFileSession::fstat(GateIStream &is) {
     Request r(hdl());
 
@@ -332,6 +731,27 @@ void M3FSFileSession::fstat(GateIStream &is) {
     reply_vmsg(is, Errors::NONE, info);
 }
 
+void M3FSFileSession::prefetch_next(Request &r, INode *inode) {
+    // start with the second read in a row; a single one is no sign of a sequential access
+    if(_seqreads < 2 || _advice == File::RANDOM || _fileoff >= inode->size)
+        return;
+
+    Extent *indir = nullptr;
+    Extent *ext = INodes::get_extent(r, inode, _extent, &indir, false);
+    if(ext && ext->length > 0)
+        hdl().backend()->prefetch_filedata(r, ext, _extoff, _accessed);
+}
+
+void M3FSFileSession::commit_write(Request &r, size_t nbytes) {
+    if(_wr_blocks == 0)
+        return;
+
+    uint32_t blocksize = hdl().sb().blocksize;
+    size_t blocks = Math::min(_wr_blocks, (_wr_capoff + nbytes + blocksize - 1) / blocksize);
+    hdl().backend()->commit_filedata(r, _wr_bno, blocks, _wr_blocks);
+    _wr_blocks = 0;
+}
+
 Errors::Code M3FSFileSession::commit(Request &r, INode *inode, size_t submit) {
     assert(submit > 0);
 
@@ -346,10 +766,12 @@ Errors::Code M3FSFileSession::commit(Request &r, INode *inode, size_t submit) {
     size_t lastoff = _lastoff;
     bool truncated = submit < _lastbytes;
     size_t prev_ext_len = 0;
+    OpenFiles::OpenFile *ofile = r.hdl().files().get_file(_ino);
+    assert(ofile != nullptr);
     if(_append_ext) {
         uint32_t blocksize = r.hdl().sb().blocksize;
-        size_t blocks = (submit + blocksize - 1) / blocksize;
-        size_t old_len = _append_ext->length;
+        uint32_t blocks = static_cast<uint32_t>((submit + blocksize - 1) / blocksize);
+        uint32_t old_len = _append_ext->length;
 
         // append extent to file
         _append_ext->length = blocks;
@@ -357,9 +779,11 @@ Errors::Code M3FSFileSession::commit(Request &r, INode *inode, size_t submit) {
         if(res != Errors::NONE)
             return res;
 
-        // free superfluous blocks
-        if(old_len > blocks)
-            r.hdl().blocks().free(r, _append_ext->start + blocks, old_len - blocks);
+        // keep the superfluous blocks for the next append instead of freeing them. this way, the
+        // next extent continues behind this one, even if other files are appended to meanwhile.
+        ofile->appended += blocks;
+        Extent rest = {_append_ext->start + blocks, old_len - blocks};
+        r.hdl().files().reserve(r, ofile, rest);
 
         _extlen = blocks * blocksize;
         // have we appended the new extent to the previous extent?
@@ -385,8 +809,6 @@ Errors::Code M3FSFileSession::commit(Request &r, INode *inode, size_t submit) {
     INodes::mark_dirty(r, inode->inode);
 
     // stop appending
-    OpenFiles::OpenFile *ofile = r.hdl().files().get_file(_ino);
-    assert(ofile != nullptr);
     assert(ofile->appending);
     ofile->appending = false;
 
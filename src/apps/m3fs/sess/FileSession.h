@@ -21,6 +21,7 @@
 
 #include <m3/VPE.h>
 #include <m3/com/SendGate.h>
+#include <m3/vfs/File.h>
 
 #include <fs/internal.h>
 
@@ -58,6 +59,11 @@ struct CapContainer {
 
 class M3FSFileSession : public M3FSSession, public m3::SListItem {
 public:
+    // the number of EPs a client can delegate to us; the second is used for read-ahead
+    static const size_t MAX_CLIENT_EPS = 2;
+    // the max. number of extents per window; the exchange args hold the lengths and one offset
+    static const size_t MAX_WINDOW_EXTS = 7;
+
     explicit M3FSFileSession(FSHandle &handle, capsel_t srv_sel, M3FSMetaSession *meta,
                              const m3::String &filename, int flags, m3::inodeno_t ino);
     virtual ~M3FSFileSession();
@@ -71,6 +77,9 @@ public:
     virtual void commit(m3::GateIStream &is) override;
     virtual void seek(m3::GateIStream &is) override;
     virtual void fstat(m3::GateIStream &is) override;
+    virtual void locate(m3::GateIStream &is) override;
+    virtual void readdir(m3::GateIStream &is) override;
+    virtual void advise(m3::GateIStream &is) override;
 
     m3::inodeno_t ino() const {
         return _ino;
@@ -82,16 +91,21 @@ public:
     m3::KIF::CapRngDesc caps() const {
         return m3::KIF::CapRngDesc(m3::KIF::CapRngDesc::OBJ, sel(), 2);
     }
-    void set_ep(capsel_t ep) {
-        _epcap = ep;
+    void set_ep(capsel_t ep, size_t idx = 0) {
+        _epcap[idx] = ep;
     }
 
     m3::Errors::Code clone(capsel_t srv, m3::KIF::Service::ExchangeData &data);
     m3::Errors::Code get_mem(m3::KIF::Service::ExchangeData &data);
+    m3::Errors::Code get_window(m3::KIF::Service::ExchangeData &data);
+    m3::Errors::Code commit_bytes(size_t nbytes, size_t *filesize);
 
 private:
     void next_in_out(m3::GateIStream &is, bool out);
     m3::Errors::Code commit(Request &r, m3::INode *inode, size_t submit);
+    void commit_write(Request &r, size_t nbytes);
+    void prefetch_next(Request &r, m3::INode *inode);
+    void prefetch_or_drop(Request &r, m3::INode *inode, size_t off, size_t len, bool prefetch);
 
     size_t _extent;
     size_t _extoff;
@@ -100,13 +114,24 @@ private:
     size_t _fileoff;
     size_t _lastbytes;
     size_t _accessed;
+    m3::File::Advice _advice;
+    // the number of reads in a row that continued at the previous position
+    size_t _seqreads;
     bool _moved_forward;
 
     bool _appending;
     m3::Extent *_append_ext;
 
-    capsel_t _last;
-    capsel_t _epcap;
+    // the blocks handed out by the last next_out; written back as far as the client commits them
+    m3::blockno_t _wr_bno;
+    size_t _wr_capoff;
+    size_t _wr_blocks;
+
+    capsel_t _last[MAX_CLIENT_EPS];
+    capsel_t _epcap[MAX_CLIENT_EPS];
+    // the memory caps of the last window
+    capsel_t _win;
+    size_t _wincount;
     m3::SendGate *_sgate;
 
     int _oflags;
@@ -60,11 +60,21 @@ void M3FSMetaSession::open_private_file(m3::GateIStream &is) {
 void M3FSMetaSession::close_private_file(m3::GateIStream &is) {
     size_t id;
     is >> id;
+    Errors::Code res = Errors::NONE;
     if(_files[id] != nullptr) {
+        // the client might let us commit the written data as part of the close
+        size_t nbytes = 0;
+        if(is.remaining() > 0)
+            is >> nbytes;
+        if(nbytes > 0) {
+            size_t filesize;
+            res = _files[id]->commit_bytes(nbytes, &filesize);
+        }
+
         delete _files[id];
         _files[id] = nullptr;
     }
-    reply_error(is, Errors::NONE);
+    reply_error(is, res);
 }
 
 Errors::Code M3FSMetaSession::open_file(capsel_t srv, KIF::Service::ExchangeData &data) {
@@ -86,7 +96,7 @@ Errors::Code M3FSMetaSession::open_file(capsel_t srv, KIF::Service::ExchangeData
 }
 
 static const char *decode_flags(int flags) {
-    static char buf[9];
+    static char buf[12];
     buf[0] = (flags & FILE_R)       ? 'r' : '-';
     buf[1] = (flags & FILE_W)       ? 'w' : '-';
     buf[2] = (flags & FILE_X)       ? 'x' : '-';
@@ -95,7 +105,10 @@ static const char *decode_flags(int flags) {
     buf[5] = (flags & FILE_CREATE)  ? 'c' : '-';
     buf[6] = (flags & FILE_NODATA)  ? 'd' : '-';
     buf[7] = (flags & FILE_NOSESS)  ? 's' : '-';
-    buf[8] = '\0';
+    buf[8] = (flags & FILE_READAHEAD) ? 'p' : '-';
+    buf[9] = (flags & FILE_WRBEHIND)  ? 'b' : '-';
+    buf[10] = (flags & FILE_EXTWIN)   ? 'g' : '-';
+    buf[11] = '\0';
     return buf;
 }
 
@@ -181,6 +194,33 @@ void M3FSMetaSession::fstat(GateIStream &is) {
         reply_error(is, Errors::INV_ARGS);
 }
 
+void M3FSMetaSession::locate(GateIStream &is) {
+    size_t id;
+    is >> id;
+    if(_files[id] != nullptr)
+        _files[id]->locate(is);
+    else
+        reply_error(is, Errors::INV_ARGS);
+}
+
+void M3FSMetaSession::readdir(GateIStream &is) {
+    size_t id;
+    is >> id;
+    if(_files[id] != nullptr)
+        _files[id]->readdir(is);
+    else
+        reply_error(is, Errors::INV_ARGS);
+}
+
+void M3FSMetaSession::advise(GateIStream &is) {
+    size_t id;
+    is >> id;
+    if(_files[id] != nullptr)
+        _files[id]->advise(is);
+    else
+        reply_error(is, Errors::INV_ARGS);
+}
+
 void M3FSMetaSession::stat(GateIStream &is) {
     EVENT_TRACER_FS_stat();
     String path;
@@ -64,6 +64,9 @@ public:
     virtual void commit(m3::GateIStream &is) override;
     virtual void seek(m3::GateIStream &is) override;
     virtual void fstat(m3::GateIStream &is) override;
+    virtual void locate(m3::GateIStream &is) override;
+    virtual void readdir(m3::GateIStream &is) override;
+    virtual void advise(m3::GateIStream &is) override;
 
     virtual void stat(m3::GateIStream &is) override;
     virtual void mkdir(m3::GateIStream &is) override;
@@ -16,7 +16,10 @@
 
 #include "OpenFiles.h"
 
+#include <base/util/Math.h>
+
 #include "../data/INodes.h"
+#include "../FSHandle.h"
 
 void OpenFiles::delete_file(m3::inodeno_t ino) {
     Request r(_hdl);
@@ -44,11 +47,51 @@ void OpenFiles::rem_sess(M3FSFileSession *sess) {
     file->sessions.remove(sess);
 
     if(file->sessions.length() == 0) {
+        Request r(_hdl);
+        release(r, file);
         _files.remove(file);
-        if(file->deleted) {
-            Request r(_hdl);
+        if(file->deleted)
             INodes::free(r, sess->ino());
-        }
         delete file;
     }
 }
+
+size_t OpenFiles::prealloc_blocks(const OpenFile *file) const {
+    size_t blocks = m3::Math::min(file->appended, MAX_PREALLOC);
+    // don't let a single file take more than a small share of the free blocks
+    blocks = m3::Math::min(blocks, static_cast<size_t>(_hdl.sb().free_blocks / 16));
+    return m3::Math::max(blocks, _hdl.extend());
+}
+
+m3::Extent OpenFiles::take_reserved(OpenFile *file) {
+    m3::Extent ext = file->reserved;
+    if(ext.length > 0) {
+        _reserved.remove(file);
+        file->reserved = m3::Extent();
+    }
+    return ext;
+}
+
+void OpenFiles::reserve(Request &r, OpenFile *file, const m3::Extent &ext) {
+    release(r, file);
+    if(ext.length > 0) {
+        file->reserved = ext;
+        _reserved.append(file);
+    }
+}
+
+size_t OpenFiles::release_all(Request &r) {
+    size_t total = 0;
+    while(_reserved.length() > 0) {
+        OpenFile *file = &*_reserved.begin();
+        total += file->reserved.length;
+        release(r, file);
+    }
+    return total;
+}
+
+void OpenFiles::release(Request &r, OpenFile *file) {
+    m3::Extent ext = take_reserved(file);
+    if(ext.length > 0)
+        _hdl.blocks().free(r, ext.start, ext.length);
+}
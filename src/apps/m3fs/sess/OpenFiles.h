@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <base/col/DList.h>
 #include <base/col/SList.h>
 #include <base/col/Treap.h>
 
@@ -27,21 +28,32 @@ class FSHandle;
 
 class OpenFiles {
 public:
-    struct OpenFile : public m3::TreapNode<OpenFile, m3::inodeno_t> {
+    // the max. number of blocks that are allocated at once for appending writers
+    static const size_t MAX_PREALLOC = 4096;
+
+    struct OpenFile : public m3::TreapNode<OpenFile, m3::inodeno_t>, public m3::DListItem {
         explicit OpenFile(m3::inodeno_t ino)
             : m3::TreapNode<OpenFile, m3::inodeno_t>(ino),
+              m3::DListItem(),
               appending(false),
-              deleted(false) {
+              deleted(false),
+              appended(),
+              reserved() {
         }
 
         bool appending;
         bool deleted;
+        // the number of blocks appended since the file has been opened
+        size_t appended;
+        // the blocks behind the end of the file that are kept for the next append
+        m3::Extent reserved;
         m3::SList<M3FSFileSession> sessions;
     };
 
     explicit OpenFiles(FSHandle &hdl)
         : _hdl(hdl),
-          _files() {
+          _files(),
+          _reserved() {
     }
 
     OpenFile *get_file(m3::inodeno_t ino) {
@@ -53,7 +65,30 @@ public:
     void add_sess(M3FSFileSession *sess);
     void rem_sess(M3FSFileSession *sess);
 
+    /**
+     * Determines the number of blocks to allocate for the next append to <file>. It grows with the
+     * number of blocks that have been appended to it, so that log-like files get long extents.
+     */
+    size_t prealloc_blocks(const OpenFile *file) const;
+
+    /**
+     * Takes the reserved blocks of <file>, if any
+     */
+    m3::Extent take_reserved(OpenFile *file);
+    /**
+     * Reserves the blocks <ext> for the next append to <file>
+     */
+    void reserve(Request &r, OpenFile *file, const m3::Extent &ext);
+    /**
+     * Frees the blocks reserved for all files and returns the number of blocks
+     */
+    size_t release_all(Request &r);
+
 private:
+    void release(Request &r, OpenFile *file);
+
     FSHandle &_hdl;
     m3::Treap<OpenFile> _files;
+    // the files that have reserved blocks
+    m3::DList<OpenFile> _reserved;
 };
@@ -70,6 +70,15 @@ public:
     virtual void fstat(m3::GateIStream &is) {
         m3::reply_error(is, m3::Errors::NOT_SUP);
     }
+    virtual void locate(m3::GateIStream &is) {
+        m3::reply_error(is, m3::Errors::NOT_SUP);
+    }
+    virtual void readdir(m3::GateIStream &is) {
+        m3::reply_error(is, m3::Errors::NOT_SUP);
+    }
+    virtual void advise(m3::GateIStream &is) {
+        m3::reply_error(is, m3::Errors::NOT_SUP);
+    }
 
     virtual void stat(m3::GateIStream &is) {
         m3::reply_error(is, m3::Errors::NOT_SUP);
@@ -204,8 +204,7 @@ public:
         add_operation(NetworkManager::CONNECT, &NMRequestHandler::connect);
         add_operation(NetworkManager::CLOSE, &NMRequestHandler::close);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&NMRequestHandler::handle_message, this, _1));
+        _rgate.start<net_reqh_base_t, &net_reqh_base_t::handle_message>(this);
     }
 
     virtual Errors::Code open(NMSession **sess, capsel_t srv_sel, word_t) override {
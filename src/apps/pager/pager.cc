@@ -51,8 +51,7 @@ public:
         add_operation(Pager::MAP_ANON, &MemReqHandler::map_anon);
         add_operation(Pager::UNMAP, &MemReqHandler::unmap);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&MemReqHandler::handle_message, this, _1));
+        _rgate.start<base_class_t, &base_class_t::handle_message>(this);
     }
 
     virtual Errors::Code open(AddrSpace **sess, capsel_t srv_sel, word_t) override {
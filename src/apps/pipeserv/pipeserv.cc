@@ -47,8 +47,7 @@ public:
         add_operation(GenericFile::NEXT_OUT, &PipeServiceHandler::next_out);
         add_operation(GenericFile::COMMIT, &PipeServiceHandler::commit);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&PipeServiceHandler::handle_message, this, _1));
+        _rgate.start<base_class, &base_class::handle_message>(this);
     }
 
     virtual Errors::Code open(PipeSession **sess, capsel_t srv_sel, word_t arg) override {
@@ -23,6 +23,8 @@
 #include <m3/pipe/IndirectPipe.h>
 #include <m3/vfs/VFS.h>
 #include <m3/vfs/FileRef.h>
+#include <m3/vfs/GenericFile.h>
+#include <m3/vfs/IOQueue.h>
 #include <m3/vfs/Dir.h>
 
 #include <vector>
@@ -210,6 +212,123 @@ static void append_with_read() {
     check_content(small_file, sizeof(largebuf) * 2);
 }
 
+static void interleaved_appends() {
+    const char *names[] = {"/app1.bin", "/app2.bin"};
+    const size_t ROUNDS = 64;
+
+    for(size_t i = 0; i < sizeof(largebuf); ++i)
+        largebuf[i] = i % 100;
+
+    {
+        FileRef file1(names[0], FILE_W | FILE_TRUNC | FILE_CREATE);
+        FileRef file2(names[1], FILE_W | FILE_TRUNC | FILE_CREATE);
+        if(Errors::occurred())
+            exitmsg("open of " << names[0] << " or " << names[1] << " failed");
+
+        // both files grow at the same time, so that their appends are interleaved
+        for(size_t i = 0; i < ROUNDS; ++i) {
+            assert_int(file1->write_all(largebuf, sizeof(largebuf)), Errors::NONE);
+            assert_int(file2->write_all(largebuf, sizeof(largebuf)), Errors::NONE);
+        }
+    }
+
+    for(size_t i = 0; i < ARRAY_SIZE(names); ++i) {
+        check_content(names[i], sizeof(largebuf) * ROUNDS);
+        assert_int(VFS::unlink(names[i]), Errors::NONE);
+    }
+}
+
+static void ioqueue_reads() {
+    // more files than file EPs, so that the queue has to wait for EPs of requests in flight
+    const size_t NUM = FileTable::MAX_EPS * 2 + 1;
+    const size_t STEP_SIZE = 256;
+    static_assert(NUM <= IOQueue::SLOTS, "Too many files");
+
+    alignas(DTU_PKG_SIZE) static uint8_t bufs[NUM][STEP_SIZE];
+    fd_t fds[NUM];
+    for(size_t i = 0; i < NUM; ++i) {
+        fds[i] = VFS::open(pat_file, FILE_R);
+        if(fds[i] == FileTable::INVALID)
+            exitmsg("Unable to open '" << pat_file << "' for reading");
+    }
+
+    {
+        IOQueue queue;
+        for(size_t round = 0; round < 4; ++round) {
+            for(size_t i = 0; i < NUM; ++i)
+                assert_true(queue.read(fds[i], bufs[i], STEP_SIZE, i));
+            assert_size(queue.wait(NUM), NUM);
+
+            IOQueue::Completion c;
+            while(queue.complete(c)) {
+                assert_int(c.err, Errors::NONE);
+                assert_ssize(c.res, static_cast<ssize_t>(STEP_SIZE));
+                for(size_t j = 0; j < STEP_SIZE; ++j)
+                    assert_uint(bufs[c.user][j], (round * STEP_SIZE + j) & 0xFF);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < NUM; ++i)
+        VFS::close(fds[i]);
+}
+
+static void ioqueue_writes() {
+    const size_t NUM = FileTable::MAX_EPS * 2 + 1;
+    const size_t TOTAL = sizeof(largebuf) * 8;
+    static_assert(NUM <= IOQueue::SLOTS, "Too many files");
+
+    for(size_t i = 0; i < sizeof(largebuf); ++i)
+        largebuf[i] = i % 100;
+
+    char names[NUM][16];
+    fd_t fds[NUM];
+    size_t pos[NUM];
+    for(size_t i = 0; i < NUM; ++i) {
+        OStringStream os(names[i], sizeof(names[i]));
+        os << "/ioq" << i << ".bin";
+        fds[i] = VFS::open(names[i], FILE_W | FILE_TRUNC | FILE_CREATE);
+        if(fds[i] == FileTable::INVALID)
+            exitmsg("Unable to open '" << names[i] << "' for writing");
+        pos[i] = 0;
+    }
+
+    {
+        IOQueue queue;
+        // the buffer contains whole periods of the pattern, so that we can always continue with
+        // the offset within the buffer
+        for(size_t i = 0; i < NUM; ++i)
+            assert_true(queue.write(fds[i], largebuf, sizeof(largebuf), i));
+
+        size_t active = NUM;
+        while(active > 0 && queue.wait() > 0) {
+            IOQueue::Completion c;
+            while(queue.complete(c)) {
+                assert_int(c.err, Errors::NONE);
+                if(c.res <= 0) {
+                    active--;
+                    continue;
+                }
+
+                pos[c.user] += static_cast<size_t>(c.res);
+                if(pos[c.user] < TOTAL) {
+                    size_t off = pos[c.user] % sizeof(largebuf);
+                    size_t amount = Math::min(sizeof(largebuf) - off, TOTAL - pos[c.user]);
+                    assert_true(queue.write(fds[c.user], largebuf + off, amount, c.user));
+                }
+                else
+                    active--;
+            }
+        }
+    }
+
+    for(size_t i = 0; i < NUM; ++i) {
+        VFS::close(fds[i]);
+        check_content(names[i], TOTAL);
+        assert_int(VFS::unlink(names[i]), Errors::NONE);
+    }
+}
+
 static void file_mux() {
     const size_t NUM = 6;
     const size_t STEP_SIZE = 400;
@@ -238,6 +357,35 @@ static void file_mux() {
         delete files[i];
 }
 
+static void many_files() {
+    const size_t NUM = FileTable::INIT_FDS * 2;
+
+    fd_t fds[NUM];
+    for(size_t i = 0; i < NUM; ++i) {
+        fds[i] = VFS::open(pat_file, FILE_R);
+        if(fds[i] == FileTable::INVALID)
+            exitmsg("Unable to open '" << pat_file << "' for reading");
+    }
+    assert_true(VPE::self().fds()->capacity() > FileTable::INIT_FDS);
+
+    // one file is read constantly, the others only now and then; the busy one keeps its EP
+    GenericFile *hot = static_cast<GenericFile*>(VPE::self().fds()->get(fds[0]));
+    uint8_t buf[64];
+    for(size_t round = 0; round < 4; ++round) {
+        for(size_t i = 1; i < NUM; ++i) {
+            assert_ssize(hot->read(buf, sizeof(buf)), static_cast<ssize_t>(sizeof(buf)));
+
+            File *cold = VPE::self().fds()->get(fds[i]);
+            assert_ssize(cold->read(buf, 1), 1);
+            assert_uint(buf[0], round & 0xFF);
+        }
+    }
+    assert_size(hot->ep_steals(), 0);
+
+    for(size_t i = 0; i < NUM; ++i)
+        VFS::close(fds[i]);
+}
+
 static void pipe_mux() {
     const size_t NUM = 6;
     const size_t STEP_SIZE = 16;
@@ -423,6 +571,50 @@ static void transactions() {
     }
 }
 
+static void overwrite_middle_block() {
+    const char *tmp_file = "/middle.bin";
+    const size_t blocksize = 4096;
+    const size_t blocks = 4;
+    alignas(DTU_PKG_SIZE) static uint8_t blockbuf[blocksize];
+
+    {
+        FileRef file(tmp_file, FILE_W | FILE_CREATE | FILE_TRUNC);
+        if(Errors::occurred())
+            exitmsg("open of " << tmp_file << " failed");
+
+        for(size_t i = 0; i < blocks; ++i) {
+            memset(blockbuf, static_cast<int>(i + 1), sizeof(blockbuf));
+            assert_int(file->write_all(blockbuf, sizeof(blockbuf)), Errors::NONE);
+        }
+    }
+
+    // overwrite a block in the middle of the cached chunk
+    {
+        FileRef file(tmp_file, FILE_RW);
+        if(Errors::occurred())
+            exitmsg("open of " << tmp_file << " failed");
+
+        assert_ssize(file->seek(2 * blocksize, M3FS_SEEK_SET), static_cast<ssize_t>(2 * blocksize));
+        memset(blockbuf, 0xFF, sizeof(blockbuf));
+        assert_int(file->write_all(blockbuf, sizeof(blockbuf)), Errors::NONE);
+    }
+
+    FileRef file(tmp_file, FILE_R);
+    if(Errors::occurred())
+        exitmsg("open of " << tmp_file << " failed");
+
+    // evict the chunk to write it back and read it from the disk again
+    assert_int(file->advise(0, blocks * blocksize, File::DONTNEED), Errors::NONE);
+
+    for(size_t i = 0; i < blocks; ++i) {
+        assert_ssize(file->read(blockbuf, sizeof(blockbuf)),
+                     static_cast<ssize_t>(sizeof(blockbuf)));
+        uint8_t exp = i == 2 ? 0xFF : static_cast<uint8_t>(i + 1);
+        for(size_t j = 0; j < sizeof(blockbuf); ++j)
+            assert_int(blockbuf[j], exp);
+    }
+}
+
 static void buffered_read_until_end() {
     FStream file(pat_file, FILE_R, 256);
     if(Errors::occurred())
@@ -483,6 +675,30 @@ static void buffered_read_with_large_buf() {
     assert_true(file.eof() && !file.error());
 }
 
+static void buffered_read_mixed_sizes() {
+    FStream file(pat_file, FILE_R, 64);
+    if(Errors::occurred())
+        exitmsg("open of " << pat_file << " failed");
+
+    // small reads let the buffer grow; the large ones take the buffered data first
+    size_t count, pos = 0, step = 0;
+    size_t sizes[] = {1, 7, sizeof(largebuf), 13, 64, 3};
+    while((count = file.read(largebuf, sizes[step++ % ARRAY_SIZE(sizes)])) > 0) {
+        for(size_t i = 0; i < count; ++i)
+            assert_int(largebuf[i], pos++ & 0xFF);
+    }
+    assert_true(file.eof() && !file.error());
+
+    // throwing away the buffered data should not hurt either
+    file.clear_state();
+    file.seek(100, M3FS_SEEK_SET);
+    assert_size(file.read(largebuf, 1), 1);
+    assert_int(largebuf[0], 100);
+    file.seek(10, M3FS_SEEK_CUR);
+    assert_size(file.read(largebuf, 1), 1);
+    assert_int(largebuf[0], 111);
+}
+
 static void buffered_read_and_write() {
     FStream file(pat_file, 600, 256, FILE_RW);
     if(Errors::occurred())
@@ -560,7 +776,11 @@ void tfs() {
     RUN_TEST(truncate);
     RUN_TEST(append);
     RUN_TEST(append_with_read);
+    RUN_TEST(interleaved_appends);
     RUN_TEST(file_mux);
+    RUN_TEST(many_files);
+    RUN_TEST(ioqueue_reads);
+    RUN_TEST(ioqueue_writes);
     RUN_TEST(pipe_mux);
     RUN_TEST(file_errors);
 #if DTU_PKG_SIZE == 8
@@ -570,9 +790,11 @@ void tfs() {
     RUN_TEST(read_file_in_large_steps);
     RUN_TEST(write_file_and_read_again);
     RUN_TEST(transactions);
+    RUN_TEST(overwrite_middle_block);
     RUN_TEST(buffered_read_until_end);
     RUN_TEST(buffered_read_with_seek);
     RUN_TEST(buffered_read_with_large_buf);
+    RUN_TEST(buffered_read_mixed_sizes);
     RUN_TEST(buffered_read_and_write);
 
     // have to be last: overwrite /pat.bin
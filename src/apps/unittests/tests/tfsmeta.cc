@@ -65,6 +65,42 @@ static void dir_listing() {
     }
 }
 
+static void dir_listing_attrs() {
+    const char *dirname = "/largedir";
+    Dir dir(dirname);
+    if(Errors::occurred())
+        exitmsg("open of " << dirname << " failed");
+
+    // the file information sent along with the entries has to match the one of stat
+    Dir::Entry e;
+    FileInfo info;
+    size_t count = 0;
+    while(dir.readdir(e, info)) {
+        char tmp[64];
+        OStringStream os(tmp, sizeof(tmp));
+        os << dirname << "/" << e.name;
+
+        FileInfo sinfo;
+        assert_int(VFS::stat(os.str(), sinfo), Errors::NONE);
+        assert_size(info.inode, e.nodeno);
+        assert_size(info.inode, sinfo.inode);
+        assert_size(info.mode, sinfo.mode);
+        assert_size(info.size, sinfo.size);
+        count++;
+    }
+    assert_size(count, 82);
+
+    // switching between both variants must not skip entries
+    dir.reset();
+    for(count = 0; count < 10 && dir.readdir(e); ++count)
+        ;
+    while(dir.readdir(e, info)) {
+        assert_size(info.inode, e.nodeno);
+        count++;
+    }
+    assert_size(count, 82);
+}
+
 static void meta_operations() {
     assert_int(VFS::mkdir("/example", 0755), Errors::NONE);
     assert_int(VFS::mkdir("/example", 0755), Errors::EXISTS);
@@ -97,6 +133,117 @@ static void meta_operations() {
     assert_int(VFS::unlink("/newpath"), Errors::NONE);
 }
 
+static size_t count_entries(const char *dirname) {
+    Dir dir(dirname);
+    if(Errors::occurred())
+        exitmsg("open of " << dirname << " failed");
+
+    Dir::Entry e;
+    size_t count = 0;
+    while(dir.readdir(e))
+        count++;
+    return count;
+}
+
+static void many_entries() {
+    // long names, so that the directory needs more than one block
+    const size_t COUNT = 100;
+    const char *dirname = "/manydir";
+    char path[128];
+
+    assert_int(VFS::mkdir(dirname, 0755), Errors::NONE);
+    for(size_t i = 0; i < COUNT; ++i) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        FStream f(os.str(), FILE_W | FILE_CREATE);
+        if(Errors::occurred())
+            exitmsg("open of " << os.str() << " failed");
+    }
+    assert_size(count_entries(dirname), COUNT + 2);
+
+    // remove every second one; the others have to stay reachable
+    for(size_t i = 0; i < COUNT; i += 2) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        assert_int(VFS::unlink(os.str()), Errors::NONE);
+    }
+    for(size_t i = 0; i < COUNT; ++i) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        FileInfo info;
+        assert_int(VFS::stat(os.str(), info), (i % 2) == 0 ? Errors::NO_SUCH_FILE : Errors::NONE);
+    }
+    assert_size(count_entries(dirname), COUNT / 2 + 2);
+
+    for(size_t i = 1; i < COUNT; i += 2) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        assert_int(VFS::unlink(os.str()), Errors::NONE);
+    }
+    assert_size(count_entries(dirname), 2);
+    assert_int(VFS::rmdir(dirname), Errors::NONE);
+}
+
+static void large_hashed_dir() {
+    // enough entries to split the buckets many times; the directory has to stay hashed
+    const size_t COUNT = 3000;
+    const char *dirname = "/largedir";
+    char path[128];
+
+    assert_int(VFS::mkdir(dirname, 0755), Errors::NONE);
+    for(size_t i = 0; i < COUNT; ++i) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        fd_t fd = VFS::open(os.str(), FILE_W | FILE_CREATE);
+        if(fd == FileTable::INVALID)
+            exitmsg("open of " << os.str() << " failed");
+        VFS::close(fd);
+    }
+
+    FileInfo info;
+    assert_int(VFS::stat(dirname, info), Errors::NONE);
+    assert_true((info.flags & INODE_HASHED) != 0);
+    assert_size(count_entries(dirname), COUNT + 2);
+
+    for(size_t i = 0; i < COUNT; ++i) {
+        OStringStream os(path, sizeof(path));
+        os << dirname << "/a-directory-entry-with-a-rather-long-name-" << i;
+        assert_int(VFS::unlink(os.str()), Errors::NONE);
+    }
+    assert_int(VFS::stat(dirname, info), Errors::NONE);
+    assert_true((info.flags & INODE_HASHED) != 0);
+    assert_int(VFS::rmdir(dirname), Errors::NONE);
+}
+
+static void repeated_lookups() {
+    FileInfo info;
+
+    // the failed lookups are remembered as well; creating the file has to replace that
+    assert_int(VFS::stat("/lookupdir/file", info), Errors::NO_SUCH_FILE);
+    assert_int(VFS::mkdir("/lookupdir", 0755), Errors::NONE);
+    assert_int(VFS::stat("/lookupdir/file", info), Errors::NO_SUCH_FILE);
+    {
+        FStream f("/lookupdir/file", FILE_W | FILE_CREATE);
+        f << "test\n";
+    }
+    assert_int(VFS::stat("/lookupdir/file", info), Errors::NONE);
+    assert_size(info.size, 5);
+
+    assert_int(VFS::unlink("/lookupdir/file"), Errors::NONE);
+    assert_int(VFS::stat("/lookupdir/file", info), Errors::NO_SUCH_FILE);
+
+    // a new directory with the same name must not see the old entries
+    assert_int(VFS::stat("/lookupdir/.", info), Errors::NONE);
+    assert_int(VFS::rmdir("/lookupdir"), Errors::NONE);
+    assert_int(VFS::stat("/lookupdir/.", info), Errors::NO_SUCH_FILE);
+    {
+        FStream f("/lookupdir", FILE_W | FILE_CREATE);
+        f << "test\n";
+    }
+    assert_int(VFS::stat("/lookupdir/.", info), Errors::NO_SUCH_FILE);
+    assert_int(VFS::unlink("/lookupdir"), Errors::NONE);
+}
+
 static void delete_file() {
     const char *tmp_file = "/tmp_file.txt";
 
@@ -126,6 +273,10 @@ static void delete_file() {
 
 void tfsmeta() {
     RUN_TEST(dir_listing);
+    RUN_TEST(dir_listing_attrs);
     RUN_TEST(meta_operations);
+    RUN_TEST(many_entries);
+    RUN_TEST(large_hashed_dir);
+    RUN_TEST(repeated_lookups);
     RUN_TEST(delete_file);
 }
@@ -206,8 +206,7 @@ public:
         add_operation(GenericFile::NEXT_OUT, &VTermHandler::next_out);
         add_operation(GenericFile::COMMIT, &VTermHandler::commit);
 
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&VTermHandler::handle_message, this, _1));
+        _rgate.start<base_class, &base_class::handle_message>(this);
     }
 
     virtual Errors::Code open(VTermSession **sess, capsel_t srv_sel, word_t) override {
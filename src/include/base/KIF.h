@@ -161,10 +161,18 @@ struct KIF {
 
             // misc
             NOOP,
+            SYSC_STATS,
 
             COUNT
         };
 
+        /**
+         * The number of latency buckets per system call. Bucket i counts the calls that took
+         * more than 2^(i+7) and at most 2^(i+8) cycles; the first and last bucket count all
+         * faster and slower calls, respectively.
+         */
+        static const size_t STATS_BUCKETS   = 16;
+
         enum VPEOp {
             VCTRL_INIT,
             VCTRL_START,
@@ -173,6 +181,18 @@ struct KIF {
         };
         enum SrvOp {
             SCTRL_SHUTDOWN,
+            // hands a pre-created session to the kernel for clients that open a session
+            SCTRL_ADD_SESS,
+        };
+        enum SrvPolicy {
+            // the name belongs to exactly one service instance
+            SRV_EXCL,
+            // sessions are distributed among the instances in turn
+            SRV_ROUNDROBIN,
+            // sessions go to the instance with the fewest pending messages
+            SRV_LEAST_PENDING,
+            // sessions go to the instance on the client's PE, if any, or a fixed one per PE
+            SRV_PE_AFFINITY,
         };
 
         struct Pagefault : public DefaultRequest {
@@ -184,6 +204,7 @@ struct KIF {
             xfer_t dst_sel;
             xfer_t vpe_sel;
             xfer_t rgate_sel;
+            xfer_t policy;
             xfer_t namelen;
             char name[32];
         } PACKED;
@@ -252,6 +273,7 @@ struct KIF {
         struct SrvCtrl : public DefaultRequest {
             xfer_t srv_sel;
             xfer_t op;
+            xfer_t arg;
         } PACKED;
 
         struct VPECtrl : public DefaultRequest {
@@ -346,6 +368,21 @@ struct KIF {
 
         struct Noop : public DefaultRequest {
         } PACKED;
+
+        struct SyscStats : public DefaultRequest {
+            xfer_t op;
+            xfer_t reset;
+        } PACKED;
+
+        struct SyscStatsReply : public DefaultReply {
+            xfer_t count;
+            xfer_t total;
+            xfer_t min;
+            xfer_t max;
+            xfer_t vpewait;
+            xfer_t srvwait;
+            xfer_t hist[STATS_BUCKETS];
+        } PACKED;
     };
 
     /**
@@ -357,7 +394,8 @@ struct KIF {
             OBTAIN,
             DELEGATE,
             CLOSE,
-            SHUTDOWN
+            SHUTDOWN,
+            OPENED,
         };
 
         struct Open : public DefaultRequest {
@@ -388,6 +426,11 @@ struct KIF {
 
         struct Shutdown : public DefaultRequest {
         } PACKED;
+
+        struct Opened : public DefaultRequest {
+            xfer_t sess;
+            xfer_t arg;
+        } PACKED;
     };
 
     /**
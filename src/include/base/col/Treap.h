@@ -137,6 +137,48 @@ public:
         return nullptr;
     }
 
+    /**
+     * Finds the node with the smallest key that is greater than or equal to the given key
+     *
+     * @param key the key
+     * @return the node or nullptr if there is none
+     */
+    T *find_ge(typename T::key_t key) const {
+        T *res = nullptr;
+        for(T *p = _root; p != nullptr; ) {
+            if(p->matches(key))
+                return static_cast<T*>(p);
+            if(key < p->key()) {
+                res = p;
+                p = p->_left;
+            }
+            else
+                p = p->_right;
+        }
+        return res;
+    }
+
+    /**
+     * Finds the node with the largest key that is less than or equal to the given key
+     *
+     * @param key the key
+     * @return the node or nullptr if there is none
+     */
+    T *find_le(typename T::key_t key) const {
+        T *res = nullptr;
+        for(T *p = _root; p != nullptr; ) {
+            if(p->matches(key))
+                return static_cast<T*>(p);
+            if(key < p->key())
+                p = p->_left;
+            else {
+                res = p;
+                p = p->_right;
+            }
+        }
+        return res;
+    }
+
     /**
      * Inserts the given node in the tree. Note that it is expected, that the key of the node is
      * already set.
@@ -70,6 +70,17 @@ enum {
     MAX_BLOCK_SIZE      = 4096,
 };
 
+// superblock features
+enum {
+    // directories with INODE_HASHED are hashed (see dir_bucket)
+    FEAT_DIR_HASH       = 1,
+};
+
+// inode flags; only valid if the superblock has FEAT_DIR_HASH
+enum {
+    INODE_HASHED        = 1,
+};
+
 constexpr inodeno_t INVALID_INO = static_cast<inodeno_t>(-1);
 
 #define M3FS_SEEK_SET 0
@@ -87,6 +98,9 @@ enum {
     FILE_CREATE = 32,
     FILE_NODATA = 64,
     FILE_NOSESS = 128,
+    FILE_READAHEAD = 256,
+    FILE_WRBEHIND = 512,
+    FILE_EXTWIN = 1024,
 };
 
 static_assert(FILE_R == MemGate::R, "FILE_R is out of sync");
@@ -109,13 +123,14 @@ struct FileInfo {
     // for debugging
     unsigned extents;
     blockno_t firstblock;
+    unsigned flags;
 };
 
 // should be 64 bytes large
 struct alignas(DTU_PKG_SIZE) INode {
     dev_t devno;
     uint16_t links;
-    uint8_t : 8;
+    uint8_t flags;
     inodeno_t inode;
     mode_t mode;
     uint64_t size;
@@ -127,6 +142,7 @@ struct alignas(DTU_PKG_SIZE) INode {
     blockno_t dindirect;
 } PACKED;
 
+// entries with namelen = 0 are unused
 struct DirEntry {
     inodeno_t nodeno;
     uint32_t namelen;
@@ -134,6 +150,32 @@ struct DirEntry {
     char name[];
 } PACKED;
 
+static inline uint32_t dir_hash(const char *name, size_t namelen) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < namelen; ++i) {
+        hash ^= static_cast<uint8_t>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Determines the block of a hashed directory with <blocks> blocks that holds the entry with given
+ * hash. This is linear hashing: with 2^l <= blocks < 2^(l+1), the first blocks - 2^l blocks have
+ * been split by the next hash bit into themselves and the blocks 2^l.., respectively. Thus, the
+ * directory grows by one block at a time and a split only moves entries out of one block.
+ */
+static inline size_t dir_bucket(uint32_t hash, size_t blocks) {
+    size_t low = 1;
+    while(low * 2 <= blocks)
+        low *= 2;
+    size_t bucket = hash & (low - 1);
+    if(bucket < blocks - low)
+        bucket = hash & (low * 2 - 1);
+    return bucket;
+}
+
 struct alignas(DTU_PKG_SIZE) SuperBlock {
     blockno_t first_inodebm_block() const {
         return 1;
@@ -162,10 +204,14 @@ struct alignas(DTU_PKG_SIZE) SuperBlock {
     uint inodes_per_block() const {
         return blocksize / sizeof(INode);
     }
+    bool hashed_dirs() const {
+        return (features & FEAT_DIR_HASH) != 0;
+    }
     uint32_t get_checksum() const {
+        // older images have no features, which keeps their checksum valid
         return 1 + blocksize * 2 + total_inodes * 3 +
             total_blocks * 5 + free_inodes * 7 + free_blocks * 11 +
-            first_free_inode * 13 + first_free_block * 17;
+            first_free_inode * 13 + first_free_block * 17 + features * 19;
     }
 
     uint32_t blocksize;
@@ -176,6 +222,7 @@ struct alignas(DTU_PKG_SIZE) SuperBlock {
     uint32_t first_free_inode;
     uint32_t first_free_block;
     uint32_t checksum;
+    uint32_t features;
 } PACKED;
 
 class Bitmap {
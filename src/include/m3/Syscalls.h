@@ -43,7 +43,8 @@ private:
     }
 
 public:
-    Errors::Code createsrv(capsel_t dst, capsel_t vpe, capsel_t rgate, const String &name);
+    Errors::Code createsrv(capsel_t dst, capsel_t vpe, capsel_t rgate, const String &name,
+                           KIF::Syscall::SrvPolicy policy = KIF::Syscall::SRV_EXCL);
     Errors::Code createsess(capsel_t dst, capsel_t srv, word_t ident);
     Errors::Code creatergate(capsel_t dst, int order, int msgorder);
     Errors::Code createsgate(capsel_t dst, capsel_t rgate, label_t label, word_t credits);
@@ -55,7 +56,7 @@ public:
                            capsel_t pages, int perms);
 
     Errors::Code activate(capsel_t ep, capsel_t gate, goff_t addr);
-    Errors::Code srvctrl(capsel_t srv, KIF::Syscall::SrvOp op);
+    Errors::Code srvctrl(capsel_t srv, KIF::Syscall::SrvOp op, xfer_t arg = 0);
     Errors::Code vpectrl(capsel_t vpe, KIF::Syscall::VPEOp op, xfer_t arg);
     Errors::Code vpewait(const capsel_t *vpes, size_t count, capsel_t *vpe, int *exitcode);
     Errors::Code derivemem(capsel_t dst, capsel_t src, goff_t offset, size_t size, int perms);
@@ -76,6 +77,8 @@ public:
                               event_t event);
 
     Errors::Code noop();
+    Errors::Code syscstats(KIF::Syscall::Operation op, KIF::Syscall::SyscStatsReply *stats,
+                           bool reset = false);
 
     void exit(int exitcode);
 
@@ -350,6 +350,15 @@ inline void GateOStream::put(const GateIStream &is) {
     _bytecount += is.remaining();
 }
 
+template<class T, void (T::*FUNC)(GateIStream&)>
+void RecvGate::RecvGateMethodWorkItem<T, FUNC>::work() {
+    const DTU::Message *msg = DTU::get().fetch_msg(_buf->ep());
+    if(msg) {
+        GateIStream is(*_buf, msg);
+        (_obj->*FUNC)(is);
+    }
+}
+
 static inline Errors::Code reply_error(GateIStream &is, m3::Errors::Code error) {
     KIF::DefaultReply reply;
     reply.error = error;
@@ -57,6 +57,19 @@ class RecvGate : public Gate {
         RecvGate *_buf;
     };
 
+    template<class T, void (T::*FUNC)(GateIStream&)>
+    class RecvGateMethodWorkItem : public RecvGateWorkItem {
+    public:
+        explicit RecvGateMethodWorkItem(RecvGate *buf, T *obj) : RecvGateWorkItem(buf), _obj(obj) {
+        }
+
+        // defined in GateStream.h, because it needs GateIStream
+        virtual void work() override;
+
+    private:
+        T *_obj;
+    };
+
     explicit RecvGate(VPE &vpe, capsel_t cap, int order, uint flags)
         : Gate(RECV_GATE, cap, flags),
           _vpe(vpe),
@@ -187,6 +200,18 @@ public:
      */
     void start(msghandler_t handler);
 
+    /**
+     * Starts to listen for received messages and calls <FUNC> on <obj> for each of them. In
+     * contrast to start(msghandler_t), the handler is known at compile time so that the call can
+     * be inlined and no std::function needs to be created.
+     *
+     * @param obj the object to call <FUNC> on
+     */
+    template<class T, void (T::*FUNC)(GateIStream&)>
+    void start(T *obj) {
+        start_with(new RecvGateMethodWorkItem<T, FUNC>(this, obj));
+    }
+
     /**
      * Stops to listen for received messages
      */
@@ -232,6 +257,8 @@ public:
     }
 
 private:
+    void start_with(RecvGateWorkItem *item);
+
     static void *allocate(VPE &vpe, epid_t ep, size_t size);
     static void free(void *);
 
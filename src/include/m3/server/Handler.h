@@ -30,6 +30,14 @@ public:
     }
 
     virtual Errors::Code open(SESS **sess, capsel_t, word_t) = 0;
+    /**
+     * Is called after the kernel handed out a pre-created session to a client (see
+     * Server::prepare_sessions). The session has been created by open() with argument 0;
+     * <arg> is the argument the client passed.
+     */
+    virtual Errors::Code opened(SESS *, word_t) {
+        return Errors::NONE;
+    }
     virtual Errors::Code obtain(SESS *, KIF::Service::ExchangeData &) {
         return Errors::NOT_SUP;
     }
@@ -23,12 +23,13 @@
 namespace m3 {
 
 struct RemoteServer {
-    explicit RemoteServer(VPE &vpe, const String &name)
+    explicit RemoteServer(VPE &vpe, const String &name,
+                          KIF::Syscall::SrvPolicy policy = KIF::Syscall::SRV_EXCL)
         : srv(ObjCap::SERVICE, VPE::self().alloc_sels(2)),
           rgate(RecvGate::create_for(vpe, srv.sel() + 1, nextlog2<256>::val,
                                                              nextlog2<256>::val)) {
         rgate.activate();
-        Syscalls::get().createsrv(srv.sel(), vpe.sel(), rgate.sel(), name);
+        Syscalls::get().createsrv(srv.sel(), vpe.sel(), rgate.sel(), name, policy);
         vpe.delegate(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, srv.sel(), 2));
     }
 
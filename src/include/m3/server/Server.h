@@ -20,6 +20,7 @@
 #include <base/Errors.h>
 #include <base/KIF.h>
 
+#include <m3/com/GateStream.h>
 #include <m3/com/RecvGate.h>
 #include <m3/server/Handler.h>
 #include <m3/Syscalls.h>
@@ -29,24 +30,23 @@ namespace m3 {
 
 template<class HDL>
 class Server : public ObjCap {
-    using handler_func = void (Server::*)(GateIStream &is);
-
 public:
-    explicit Server(const String &name, HDL *handler)
+    explicit Server(const String &name, HDL *handler,
+                    KIF::Syscall::SrvPolicy policy = KIF::Syscall::SRV_EXCL)
         : ObjCap(SERVICE, VPE::self().alloc_sel()),
           _handler(handler),
-          _ctrl_handler(),
+          _prepared(),
           _rgate(RecvGate::create(nextlog2<256>::val, nextlog2<256>::val)) {
         init();
 
-        LLOG(SERV, "create(" << name << ")");
-        Syscalls::get().createsrv(sel(), VPE::self().sel(), _rgate.sel(), name);
+        LLOG(SERV, "create(" << name << ", policy=" << policy << ")");
+        Syscalls::get().createsrv(sel(), VPE::self().sel(), _rgate.sel(), name, policy);
     }
 
     explicit Server(capsel_t caps, epid_t ep, HDL *handler)
         : ObjCap(SERVICE, caps + 0),
           _handler(handler),
-          _ctrl_handler(),
+          _prepared(),
           _rgate(RecvGate::bind(caps + 1, nextlog2<256>::val, ep)) {
         init();
     }
@@ -60,27 +60,55 @@ public:
         return *_handler;
     }
 
+    /**
+     * Creates <count> sessions in advance and hands them to the kernel. If a client opens a
+     * session, the kernel passes one of them to the client without a round trip to the server and
+     * notifies the server afterwards, which calls Handler::opened and creates a replacement. The
+     * sessions are created with argument 0; the client's argument is only passed to
+     * Handler::opened. Thus, this is only suitable if the handler does not need the argument of
+     * open to create sessions.
+     *
+     * @param count the number of sessions to keep available
+     * @return the error code
+     */
+    Errors::Code prepare_sessions(size_t count) {
+        _prepared = count;
+        for(size_t i = 0; i < count; ++i) {
+            Errors::Code res = prepare_session();
+            if(res != Errors::NONE)
+                return res;
+        }
+        return Errors::NONE;
+    }
+
 private:
+    Errors::Code prepare_session() {
+        typename HDL::session_type *sess = nullptr;
+        Errors::Code res = _handler->open(&sess, sel(), 0);
+        if(res != Errors::NONE)
+            return res;
+
+        LLOG(SERV, fmt((word_t)sess, "#x") << ": prepared");
+        return Syscalls::get().srvctrl(sel(), KIF::Syscall::SCTRL_ADD_SESS, sess->sel());
+    }
+
     void init() {
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&Server::handle_message, this, _1));
-
-        _ctrl_handler[KIF::Service::OPEN] = &Server::handle_open;
-        _ctrl_handler[KIF::Service::OBTAIN] = &Server::handle_obtain;
-        _ctrl_handler[KIF::Service::DELEGATE] = &Server::handle_delegate;
-        _ctrl_handler[KIF::Service::CLOSE] = &Server::handle_close;
-        _ctrl_handler[KIF::Service::SHUTDOWN] = &Server::handle_shutdown;
+        _rgate.start<Server, &Server::handle_message>(this);
     }
 
     void handle_message(GateIStream &is) {
         auto *req = reinterpret_cast<const KIF::DefaultRequest*>(is.message().data);
         KIF::Service::Operation op = static_cast<KIF::Service::Operation>(req->opcode);
 
-        if(static_cast<size_t>(op) < ARRAY_SIZE(_ctrl_handler)) {
-            (this->*_ctrl_handler[op])(is);
-            return;
+        switch(op) {
+            case KIF::Service::OPEN: handle_open(is); break;
+            case KIF::Service::OBTAIN: handle_obtain(is); break;
+            case KIF::Service::DELEGATE: handle_delegate(is); break;
+            case KIF::Service::CLOSE: handle_close(is); break;
+            case KIF::Service::SHUTDOWN: handle_shutdown(is); break;
+            case KIF::Service::OPENED: handle_opened(is); break;
+            default: reply_error(is, Errors::INV_ARGS); break;
         }
-        reply_error(is, Errors::INV_ARGS);
     }
 
     void handle_open(GateIStream &is) {
@@ -156,9 +184,27 @@ private:
         reply_error(is, Errors::NONE);
     }
 
+    void handle_opened(GateIStream &is) {
+        auto *req = reinterpret_cast<const KIF::Service::Opened*>(is.message().data);
+
+        LLOG(SERV, fmt((word_t)req->sess, "#x") << ": opened(arg=" << req->arg << ")");
+
+        typename HDL::session_type *sess = reinterpret_cast<typename HDL::session_type*>(req->sess);
+        Errors::Code res = _handler->opened(sess, req->arg);
+
+        reply_error(is, res);
+
+        // replace the session the kernel has handed out
+        if(_prepared > 0) {
+            Errors::Code err = prepare_session();
+            if(err != Errors::NONE)
+                LLOG(SERV, "Unable to prepare session: " << Errors::to_string(err));
+        }
+    }
+
 protected:
     HDL *_handler;
-    handler_func _ctrl_handler[5];
+    size_t _prepared;
     RecvGate _rgate;
 };
 
@@ -41,8 +41,8 @@ public:
     explicit SimpleRequestHandler()
         : RequestHandler<CLS, OP, OPCNT, SimpleSession>(),
           _rgate(RecvGate::create(nextlog2<32 * MSG_SIZE>::val, nextlog2<MSG_SIZE>::val)) {
-        using std::placeholders::_1;
-        _rgate.start(std::bind(&SimpleRequestHandler::handle_message, this, _1));
+        using base_class = RequestHandler<CLS, OP, OPCNT, SimpleSession>;
+        _rgate.template start<base_class, &base_class::handle_message>(this);
     }
 
     virtual Errors::Code open(SimpleSession **sess, capsel_t srv_sel, word_t) override {
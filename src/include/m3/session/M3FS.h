@@ -33,6 +33,7 @@ class GenericFile;
 class M3FS : public ClientSession, public FileSystem {
 public:
     friend class GenericFile;
+    friend class IOQueue;
 
     enum Operation {
         FSTAT = GenericFile::STAT,
@@ -47,9 +48,15 @@ public:
         UNLINK,
         OPEN_PRIV,
         CLOSE_PRIV,
+        LOCATE,
+        READDIR,
+        ADVISE,
         COUNT
     };
 
+    // the max. size of a reply to READDIR
+    static const size_t READDIR_MSG_SIZE = 1024;
+
     explicit M3FS(const String &service)
         : ClientSession(service, 0, VPE::self().alloc_sels(2)),
           FileSystem(),
@@ -136,24 +143,24 @@ private:
 
 template<>
 struct OStreamSize<FileInfo> {
-    static const size_t value = 9 * sizeof(xfer_t);
+    static const size_t value = 10 * sizeof(xfer_t);
 };
 
 static inline Unmarshaller &operator>>(Unmarshaller &u, FileInfo &info) {
     u >> info.devno >> info.inode >> info.mode >> info.links >> info.size >> info.lastaccess
-      >> info.lastmod >> info.extents >> info.firstblock;
+      >> info.lastmod >> info.extents >> info.firstblock >> info.flags;
     return u;
 }
 
 static inline GateIStream &operator>>(GateIStream &is, FileInfo &info) {
     is >> info.devno >> info.inode >> info.mode >> info.links >> info.size >> info.lastaccess
-      >> info.lastmod >> info.extents >> info.firstblock;
+      >> info.lastmod >> info.extents >> info.firstblock >> info.flags;
     return is;
 }
 
 static inline Marshaller &operator<<(Marshaller &m, const FileInfo &info) {
     m << info.devno << info.inode << info.mode << info.links << info.size << info.lastaccess
-      << info.lastmod << info.extents << info.firstblock;
+      << info.lastmod << info.extents << info.firstblock << info.flags;
     return m;
 }
 
@@ -44,15 +44,21 @@ class FStream : public IStream, public OStream {
 public:
     static const uint FL_LINE_BUF   = 4;
 
+    static const size_t DEF_BUFSIZE = 512;
+    static const size_t MAX_BUFSIZE = 8192;
+
     /**
-     * Binds this object to the given file descriptor and uses a buffer size of <bufsize>.
+     * Binds this object to the given file descriptor and uses a buffer size of <bufsize>. Unless
+     * FL_LINE_BUF is given, the buffers grow up to MAX_BUFSIZE if the file is accessed
+     * sequentially with small requests and shrink back if buffered data is thrown away.
      *
      * @param fd the file descriptor
      * @param perms the permissions that determine which buffer to create (FILE_*)
      * @param bufsize the size of the buffer for input/output
      * @param flags the flags (FL_*)
      */
-    explicit FStream(int fd, int perms = FILE_RW, size_t bufsize = 512, uint flags = 0);
+    explicit FStream(int fd, int perms = FILE_RW, size_t bufsize = DEF_BUFSIZE,
+                     uint flags = 0);
 
     /**
      * Opens <filename> with given permissions and a buffer size of <bufsize>. Which buffer is
@@ -62,7 +68,7 @@ public:
      * @param perms the permissions (FILE_*)
      * @param bufsize the size of the buffer for input/output
      */
-    explicit FStream(const char *filename, int perms = FILE_RW, size_t bufsize = 512);
+    explicit FStream(const char *filename, int perms = FILE_RW, size_t bufsize = DEF_BUFSIZE);
 
     /**
      * Opens <filename> with given permissions and given buffer sizes.
@@ -105,8 +111,8 @@ public:
     size_t seek(size_t offset, int whence);
 
     /**
-     * Reads <count> bytes into <dst>. If both is aligned by DTU_PKG_SIZE and the buffer is
-     * empty, the buffer is not used but it the File instance is used directly.
+     * Reads <count> bytes into <dst>. If <count> is at least as large as the buffer, the buffer is
+     * not used but the File instance is used directly, after the buffered data has been consumed.
      *
      * @param dst the destination to read into
      * @param count the number of bytes to read
@@ -115,8 +121,8 @@ public:
     size_t read(void *dst, size_t count);
 
     /**
-     * Writes <count> bytes from <src> into the file. If both is aligned by DTU_PKG_SIZE and
-     * the buffer is empty, the buffer is not used but it the File instance is used directly.
+     * Writes <count> bytes from <src> into the file. If <count> is at least as large as the
+     * buffer, the buffer is flushed and the File instance is used directly.
 
      * @param src the data to write
      * @param count the number of bytes to write
@@ -142,11 +148,16 @@ public:
     }
 
 private:
+    bool adaptive() const {
+        return (_flags & (FL_DEL_BUF | FL_LINE_BUF)) == FL_DEL_BUF;
+    }
     void set_error(ssize_t res);
 
     fd_t _fd;
     File::Buffer *_rbuf;
     File::Buffer *_wbuf;
+    // the initial input-buffer size to shrink back to
+    size_t _rsize;
     uint _flags;
 };
 
@@ -18,14 +18,21 @@
 
 #include <base/Common.h>
 
+#include <m3/com/RecvGate.h>
 #include <m3/stream/FStream.h>
 
 namespace m3 {
 
 /**
  * A directory which allows to iterate over the directory entries.
+ *
+ * For directories on m3fs, the entries are fetched in batches via READDIR, optionally including
+ * the file information of each entry. Otherwise, they are read from the file.
  */
 class Dir {
+    // the number of entries that fit into a READDIR reply at most
+    static const size_t BATCH_SIZE  = 32;
+
 public:
     // ensure that it's a multiple of DTU_PKG_SIZE
     struct Entry {
@@ -41,8 +48,13 @@ public:
      * @param path the path of the directory
      * @param flags the desired flags (FILE_R by default)
      */
-    explicit Dir(const char *path, int flags = FILE_R) : _f(path, flags, sizeof(Entry) * 16) {
+    explicit Dir(const char *path, int flags = FILE_R)
+        : _f(path, flags, sizeof(Entry) * 16),
+          _path(path),
+          _batch(),
+          _rgate() {
     }
+    ~Dir();
 
     /**
      * Retrieves the file information about this directory
@@ -60,18 +72,60 @@ public:
      * @param e the entry to write to
      * @return true if an entry has been read; false indicates EOF
      */
-    bool readdir(Entry &e);
+    bool readdir(Entry &e) {
+        return readdir(e, nullptr);
+    }
+
+    /**
+     * Reads the next directory entry into <e> and its file information into <info>. This is
+     * cheaper than a stat of each entry, because m3fs sends the information along with the entries.
+     *
+     * @param e the entry to write to
+     * @param info the file information to write to
+     * @return true if an entry has been read; false indicates EOF
+     */
+    bool readdir(Entry &e, FileInfo &info) {
+        return readdir(e, &info);
+    }
 
     /**
      * Resets the file position to the beginning
      */
     void reset() {
+        if(_batch)
+            _batch->reset();
         _f.seek(0, M3FS_SEEK_SET);
         _f.clear_state();
     }
 
 private:
+    struct Batch {
+        void reset() {
+            start = off = 0;
+            pos = count = 0;
+            eof = false;
+        }
+
+        // the offset of the first entry and the offset to request next
+        size_t start;
+        size_t off;
+        size_t pos;
+        size_t count;
+        bool eof;
+        bool attrs;
+        Entry entries[BATCH_SIZE];
+        size_t next[BATCH_SIZE];
+        FileInfo infos[BATCH_SIZE];
+    };
+
+    bool readdir(Entry &e, FileInfo *info);
+    bool read_entry(Entry &e, FileInfo *info);
+    bool fetch(bool attrs);
+
     FStream _f;
+    String _path;
+    Batch *_batch;
+    RecvGate *_rgate;
 };
 
 }
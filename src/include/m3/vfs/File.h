@@ -28,6 +28,14 @@ class VFS;
 class FStream;
 class FileTable;
 
+/**
+ * A buffer for vectored I/O (see File::readv and File::writev)
+ */
+struct IOVec {
+    void *base;
+    size_t len;
+};
+
 /**
  * The base-class of all files. Can't be instantiated.
  */
@@ -40,6 +48,29 @@ protected:
     }
 
 public:
+    /**
+     * The maximum number of bytes a file puts into the marshaller in serialize()
+     */
+    static const size_t MAX_SERIAL_SIZE = 3 * sizeof(xfer_t);
+
+    /**
+     * Hints about the intended access pattern (see advise)
+     */
+    enum Advice {
+        // no special treatment
+        NORMAL,
+        // the file is accessed sequentially
+        SEQUENTIAL,
+        // the file is accessed in random order
+        RANDOM,
+        // the given range will be accessed soon
+        WILLNEED,
+        // the given range will not be accessed anymore
+        DONTNEED,
+        // the file is accessed once
+        NOREUSE,
+    };
+
     /**
      * The default buffer implementation
      */
@@ -69,9 +100,16 @@ public:
          * Invalidates the buffer, i.e. makes it empty
          */
         void invalidate() {
-            cur = 0;
+            cur = pos = 0;
         }
 
+        /**
+         * Replaces the buffer by one with <_size> bytes. The buffer has to be empty.
+         *
+         * @param _size the new number of bytes
+         */
+        void resize(size_t _size);
+
         /**
          * Puts the given character back into the buffer.
          *
@@ -170,6 +208,46 @@ public:
      */
     virtual ssize_t write(const void *buffer, size_t count) = 0;
 
+    /**
+     * Reads at most <count> bytes at position <offset> into <buffer>, without changing the
+     * file-position. The default implementation seeks to <offset> and back again.
+     *
+     * @param buffer the buffer to read into
+     * @param count the number of bytes to read
+     * @param offset the file-position to read from
+     * @return the number of read bytes
+     */
+    virtual ssize_t pread(void *buffer, size_t count, size_t offset);
+
+    /**
+     * Writes at most <count> bytes from <buffer> at position <offset>, without changing the
+     * file-position. The default implementation seeks to <offset> and back again.
+     *
+     * @param buffer the data to write
+     * @param count the number of bytes to write
+     * @param offset the file-position to write to
+     * @return the number of written bytes
+     */
+    virtual ssize_t pwrite(const void *buffer, size_t count, size_t offset);
+
+    /**
+     * Reads into the <count> buffers in <iov>, one after another, until EOF.
+     *
+     * @param iov the buffers
+     * @param count the number of buffers
+     * @return the total number of read bytes
+     */
+    virtual ssize_t readv(const IOVec *iov, size_t count);
+
+    /**
+     * Writes the <count> buffers in <iov>, one after another.
+     *
+     * @param iov the buffers
+     * @param count the number of buffers
+     * @return the total number of written bytes
+     */
+    virtual ssize_t writev(const IOVec *iov, size_t count);
+
     /**
      * Writes <count> bytes from <buffer> into the file, if possible.
      *
@@ -189,6 +267,19 @@ public:
         return Errors::NONE;
     }
 
+    /**
+     * Tells the file how it will be accessed, which allows the file and its server to adjust their
+     * caching. The advice is only a hint, so that files are free to ignore it.
+     *
+     * @param offset the start of the range the advice applies to
+     * @param len the length of the range (0 = up to the end)
+     * @param advice the advice
+     * @return the error, if any
+     */
+    virtual Errors::Code advise(size_t, size_t, Advice) {
+        return Errors::NONE;
+    }
+
     /**
      * Performs a flush of the so far written data
      *
@@ -198,6 +289,16 @@ public:
         return Errors::NONE;
     }
 
+    /**
+     * Makes the so far written data persistent. In contrast to flush(), this also commits data
+     * whose commit has been deferred (see FILE_WRBEHIND).
+     *
+     * @return the error, if any
+     */
+    virtual Errors::Code sync() {
+        return flush();
+    }
+
     /**
      * @return the unique character for serialization
      */
@@ -219,7 +320,7 @@ public:
     virtual Errors::Code delegate(VPE &vpe) = 0;
 
     /**
-     * Serializes this object to the given marshaller.
+     * Serializes this object to the given marshaller. At most MAX_SERIAL_SIZE bytes are used.
      *
      * @param m the marshaller
      */
@@ -48,7 +48,8 @@ class FileTable {
 
 public:
     static const fd_t MAX_EPS       = EP_COUNT / 4;
-    static const fd_t MAX_FDS       = 64;
+    static const fd_t INIT_FDS      = 16;
+    static const fd_t MAX_FDS       = 1024;
     static const fd_t INVALID       = MAX_FDS;
 
     /**
@@ -57,24 +58,27 @@ public:
     explicit FileTable()
         : _file_ep_count(),
           _file_ep_victim(),
+          _file_ep_steals(),
           _file_eps(),
+          _fd_count(),
           _fds() {
     }
 
-    explicit FileTable(const FileTable &f) {
-        for(fd_t i = 0; i < MAX_FDS; ++i)
-            _fds[i] = f._fds[i];
+    explicit FileTable(const FileTable &f)
+        : FileTable() {
+        copy(f);
     }
     FileTable &operator=(const FileTable &f) {
-        if(&f != this) {
-            for(fd_t i = 0; i < MAX_FDS; ++i)
-                _fds[i] = f._fds[i];
-        }
+        if(&f != this)
+            copy(f);
         return *this;
     }
+    ~FileTable() {
+        delete[] _fds;
+    }
 
     /**
-     * Allocates a new file descriptor for given file.
+     * Allocates a new file descriptor for given file. The table grows on demand up to MAX_FDS.
      *
      * @param file the file
      * @return the file descriptor or MAX_FDS if all fds are in use
@@ -93,7 +97,7 @@ public:
      * @return true if the given file descriptor exists
      */
     bool exists(fd_t fd) const {
-        return _fds[fd] != nullptr;
+        return fd < _fd_count && _fds[fd] != nullptr;
     }
 
     /**
@@ -101,7 +105,7 @@ public:
      * @return the file for given fd
      */
     File *get(fd_t fd) const {
-        return _fds[fd];
+        return fd < _fd_count ? _fds[fd] : nullptr;
     }
 
     /**
@@ -112,9 +116,25 @@ public:
      */
     void set(fd_t fd, File *file) {
         assert(file != nullptr);
+        if(fd >= _fd_count)
+            grow(fd + 1);
         _fds[fd] = file;
     }
 
+    /**
+     * @return the number of file descriptors the table has currently space for
+     */
+    fd_t capacity() const {
+        return _fd_count;
+    }
+
+    /**
+     * @return the number of times a memory EP has been taken away from a file
+     */
+    size_t ep_steals() const {
+        return _file_ep_steals;
+    }
+
     /**
      * Delegates all files to <vpe>.
      *
@@ -132,6 +152,11 @@ public:
      */
     size_t serialize(void *buffer, size_t size) const;
 
+    /**
+     * @return the space that serialize() needs at most for the current files
+     */
+    size_t serialize_length() const;
+
     /**
      * Unserializes the given buffer into a new FileTable object.
      *
@@ -141,13 +166,23 @@ public:
      */
     static FileTable *unserialize(const void *buffer, size_t size);
 
+    /**
+     * @return true if a file without EP can get one, i.e., if not all EPs are used by files with
+     *     requests in flight
+     */
+    bool ep_available() const;
+
 private:
+    void copy(const FileTable &f);
+    void grow(fd_t min);
     epid_t request_ep(GenericFile *file);
 
     size_t _file_ep_count;
     size_t _file_ep_victim;
+    size_t _file_ep_steals;
     FileEp _file_eps[MAX_EPS];
-    File *_fds[MAX_FDS];
+    fd_t _fd_count;
+    File **_fds;
 };
 
 }
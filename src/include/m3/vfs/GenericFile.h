@@ -30,6 +30,7 @@ class M3FS;
 
 class GenericFile : public File {
     friend class FileTable;
+    friend class IOQueue;
 
 public:
     enum Operation {
@@ -55,6 +56,13 @@ public:
         return _sess;
     }
 
+    /**
+     * @return the number of times the memory EP has been taken away from this file
+     */
+    size_t ep_steals() const {
+        return _ep_steals;
+    }
+
     /**
      * @return true if there is still data to read or write without contacting the server
      */
@@ -63,7 +71,8 @@ public:
     }
 
     /**
-     * Sends the next/output input request using the given reply label
+     * Sends the next/output input request using the given reply label. Note that this is not
+     * supported for files that are opened with FILE_READAHEAD.
      *
      * @param reply_label the reply label to set
      * @return true on success
@@ -79,6 +88,20 @@ public:
      */
     size_t received_next_resp(GateIStream &is);
 
+    /**
+     * Requests the directory entries starting at byte offset <off> via a single READDIR request.
+     * The reply contains the error, the number of entries, the offset behind the last entry and
+     * the entries. Each entry consists of the inode number, the offset behind the entry, the name
+     * and, if <attrs> is true, the FileInfo.
+     *
+     * @param rgate the gate to receive the reply (at most <max> bytes) with
+     * @param off the offset to start at
+     * @param attrs whether the FileInfo of the entries should be included
+     * @param max the max. size of the reply
+     * @return the reply
+     */
+    GateIStream readdir(RecvGate &rgate, size_t off, bool attrs, size_t max);
+
     virtual Errors::Code stat(FileInfo &info) const override;
 
     virtual ssize_t seek(size_t offset, int whence) override;
@@ -86,7 +109,19 @@ public:
     virtual ssize_t read(void *buffer, size_t count) override;
     virtual ssize_t write(const void *buffer, size_t count) override;
 
+    virtual Errors::Code advise(size_t offset, size_t len, Advice advice) override;
+
+    virtual ssize_t pread(void *buffer, size_t count, size_t offset) override;
+    virtual ssize_t pwrite(const void *buffer, size_t count, size_t offset) override;
+
     virtual Errors::Code flush() override {
+        // with write-behind, the commit is deferred until sync() or close
+        if(flags() & FILE_WRBEHIND)
+            return Errors::NONE;
+        return _writing ? submit() : Errors::NONE;
+    }
+
+    virtual Errors::Code sync() override {
         return _writing ? submit() : Errors::NONE;
     }
 
@@ -121,12 +156,47 @@ public:
     }
 
 private:
+    /**
+     * With FILE_READAHEAD, the file uses a second memory EP and requests the next extent, while
+     * the current one is still read via the other EP. The replies are received via a separate
+     * receive gate to not interfere with other requests via the default receive gate.
+     */
+    enum ReadAhead {
+        RA_OFF,
+        RA_INIT,
+        RA_IDLE,
+        RA_PENDING,
+        RA_READY,
+    };
+
+    /**
+     * With FILE_EXTWIN, read-only files obtain the memory caps for a window of several consecutive
+     * extents at once and switch between them by activating our memory EP themselves. Thus, the
+     * server is only contacted once per window instead of once per extent.
+     */
+    static const size_t WINDOW_EXTS = 4;
+
     bool have_sess() const {
         return !(flags() & FILE_NOSESS);
     }
+    bool use_window() const {
+        return (flags() & FILE_EXTWIN) && !(flags() & (FILE_NOSESS | FILE_W)) && _ra == RA_OFF;
+    }
+    MemGate &cur_mem() {
+        return _ra_cur ? _ra_mg : _mg;
+    }
     void evict();
     Errors::Code submit();
+    Errors::Code received_commit_resp(GateIStream &reply);
     Errors::Code delegate_ep();
+    ssize_t server_seek(size_t offset, int whence);
+    ssize_t access_at(void *buffer, size_t count, size_t offset, bool out);
+    Errors::Code locate(size_t offset, bool out);
+    void init_readahead();
+    Errors::Code send_readahead();
+    void collect_readahead() const;
+    Errors::Code cancel_readahead(bool restore);
+    Errors::Code next_window_extent();
 
     size_t _id;
     M3FS *_sess_obj;
@@ -139,6 +209,29 @@ private:
     size_t _pos;
     size_t _len;
     bool _writing;
+    mutable ReadAhead _ra;
+    bool _ra_cur;
+    RecvGate *_ra_rg;
+    MemGate _ra_mg;
+    mutable Errors::Code _ra_res;
+    mutable size_t _ra_off;
+    mutable size_t _ra_len;
+    // the range that has been mapped by the last positional access
+    size_t _locoff;
+    size_t _locmem;
+    size_t _loclen;
+    bool _locout;
+    // the extents of the current window; the first starts at <_win_capoff>
+    capsel_t _win_sel;
+    size_t _win_idx;
+    size_t _win_count;
+    size_t _win_capoff;
+    size_t _win_len[WINDOW_EXTS];
+    // the recently transferred bytes (aged by FileTable) and the number of lost EPs
+    size_t _io_heat;
+    size_t _ep_steals;
+    // whether a request of an IOQueue is in flight, so that the EP must not be taken away
+    bool _ep_pinned;
 };
 
 }
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/util/Reference.h>
+
+#include <m3/com/RecvGate.h>
+#include <m3/vfs/FileSystem.h>
+#include <m3/vfs/FileTable.h>
+
+namespace m3 {
+
+class File;
+class GenericFile;
+class SendGate;
+
+/**
+ * A queue for asynchronous file I/O, similar to io_uring. Requests are put into the submission
+ * queue and sent to the file servers by submit(). All replies arrive at one receive gate and the
+ * reply label identifies the request. Finished requests are put into the completion queue and can
+ * be fetched with complete().
+ *
+ * The servers hand out a single credit per send gate, so only one request per send gate can be in
+ * flight. The other requests for that gate wait until it is free again, so they run in submission
+ * order. Requests that cannot be done asynchronously (e.g., for files that are not GenericFiles)
+ * are done synchronously on submission. Files keep their memory EP while a request is in flight.
+ * Thus, a read or write for a file without EP waits if all file EPs are in use by such requests.
+ *
+ * Buffers, paths and FileInfo objects passed to the queue have to stay valid until the request is
+ * completed. While requests are in flight, the affected files and file systems must not be used
+ * directly.
+ */
+class IOQueue {
+public:
+    static const size_t SLOTS       = 16;
+
+    enum Op {
+        READ,
+        WRITE,
+        COMMIT,
+        OPEN,
+        STAT,
+    };
+
+    /**
+     * A finished request
+     */
+    struct Completion {
+        // the value that was passed on submission
+        word_t user;
+        // the error, if any
+        Errors::Code err;
+        // the number of read/written bytes or the file descriptor for OPEN
+        ssize_t res;
+    };
+
+    explicit IOQueue();
+    IOQueue(const IOQueue &) = delete;
+    IOQueue &operator=(const IOQueue &) = delete;
+    ~IOQueue();
+
+    /**
+     * Queues a read of at most <count> bytes from <fd> into <buf>.
+     *
+     * @return false if the queue is full
+     */
+    bool read(fd_t fd, void *buf, size_t count, word_t user) {
+        return push(READ, fd, buf, count, nullptr, 0, user);
+    }
+    /**
+     * Queues a write of at most <count> bytes from <buf> into <fd>.
+     *
+     * @return false if the queue is full
+     */
+    bool write(fd_t fd, const void *buf, size_t count, word_t user) {
+        return push(WRITE, fd, const_cast<void*>(buf), count, nullptr, 0, user);
+    }
+    /**
+     * Queues a commit of the data written to <fd> (see File::sync).
+     *
+     * @return false if the queue is full
+     */
+    bool commit(fd_t fd, word_t user) {
+        return push(COMMIT, fd, nullptr, 0, nullptr, 0, user);
+    }
+    /**
+     * Queues an open of <path> with given permissions. The completion contains the fd.
+     *
+     * @return false if the queue is full
+     */
+    bool open(const char *path, int perms, word_t user) {
+        return push(OPEN, FileTable::INVALID, nullptr, 0, path, perms, user);
+    }
+    /**
+     * Queues a stat of <fd> into <info>.
+     *
+     * @return false if the queue is full
+     */
+    bool stat(fd_t fd, FileInfo *info, word_t user) {
+        return push(STAT, fd, info, 0, nullptr, 0, user);
+    }
+
+    /**
+     * @return the number of requests that are queued or in flight
+     */
+    size_t pending() const {
+        return _pending;
+    }
+
+    /**
+     * Sends all queued requests whose send gate is not busy.
+     *
+     * @return the number of requests in flight
+     */
+    size_t submit();
+
+    /**
+     * Submits the queued requests and waits until at least <min> completions are available or
+     * no request is pending anymore.
+     *
+     * @param min the number of completions to wait for
+     * @return the number of available completions
+     */
+    size_t wait(size_t min = 1);
+
+    /**
+     * Fetches the next completion, if there is any.
+     *
+     * @param c the completion to fill
+     * @return true if there was a completion
+     */
+    bool complete(Completion &c);
+
+private:
+    enum State {
+        FREE,
+        QUEUED,
+        SENT,
+        DONE,
+    };
+
+    struct Slot {
+        explicit Slot() : state(FREE), fs() {
+        }
+
+        State state;
+        Op op;
+        fd_t fd;
+        void *buf;
+        size_t count;
+        const char *path;
+        size_t pathpos;
+        int perms;
+        word_t user;
+        size_t seq;
+        // the gate the request is sent over (nullptr = done synchronously)
+        SendGate *gate;
+        Reference<FileSystem> fs;
+        capsel_t ep;
+        Completion result;
+    };
+
+    bool push(Op op, fd_t fd, void *buf, size_t count, const char *path, int perms, word_t user);
+    bool blocked(size_t idx) const;
+    void start(size_t idx);
+    void start_file(size_t idx, GenericFile *file);
+    void start_open(size_t idx);
+    Errors::Code send(size_t idx, SendGate &gate, const void *msg, size_t size);
+    void receive();
+    void finish(size_t idx, Errors::Code err, ssize_t res);
+
+    RecvGate _rgate;
+    Slot _slots[SLOTS];
+    size_t _seq;
+    size_t _pending;
+    size_t _inflight;
+    size_t _cq[SLOTS];
+    size_t _cqhead;
+    size_t _cqcount;
+};
+
+}
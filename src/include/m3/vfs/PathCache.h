@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2015-2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/Errors.h>
+
+#include <fs/internal.h>
+
+namespace m3 {
+
+/**
+ * Caches the results of stat for recently used paths, including lookups that failed because the
+ * path does not exist. The cache is direct mapped by a hash of the path.
+ *
+ * The cache is not coherent: it does not get notified about changes by other VPEs. Instead, each
+ * entry is only valid for the next LEASE lookups of this VPE, regardless of the time in between.
+ * Thus, stat might report outdated information for files that other VPEs change. Entries for
+ * paths that do not exist are only used once, so that files created by other VPEs show up with
+ * the next lookup. VFS::open does not use the cache at all. Changes by the own VPE (creating,
+ * removing and writing files) invalidate the cache.
+ */
+class PathCache {
+public:
+    static const size_t ENTRIES     = 32;
+    static const size_t MAX_PATH    = 64;
+    static const uint LEASE         = 128;
+
+    explicit PathCache() : _entries(), _now() {
+    }
+
+    /**
+     * Looks up <path> in the cache.
+     *
+     * @param path the path
+     * @param info will be set to the file information, if the path exists
+     * @param res will be set to the cached result of the stat
+     * @return true if the path is cached
+     */
+    bool get(const char *path, FileInfo &info, Errors::Code *res);
+
+    /**
+     * Puts the result of a stat of <path> into the cache. Only Errors::NONE and
+     * Errors::NO_SUCH_FILE are cached.
+     *
+     * @param path the path
+     * @param info the file information (only used if <res> is Errors::NONE)
+     * @param res the result of the stat
+     */
+    void put(const char *path, const FileInfo &info, Errors::Code res);
+
+    /**
+     * Removes all entries.
+     */
+    void invalidate();
+
+private:
+    struct Entry {
+        uint expires;
+        Errors::Code res;
+        FileInfo info;
+        char path[MAX_PATH];
+    };
+
+    static size_t hash(const char *path, size_t *len);
+
+    Entry _entries[ENTRIES];
+    uint _now;
+};
+
+}
@@ -23,6 +23,7 @@
 #include <m3/session/M3FS.h>
 #include <m3/vfs/File.h>
 #include <m3/vfs/FileSystem.h>
+#include <m3/vfs/PathCache.h>
 
 namespace m3 {
 
@@ -123,6 +124,14 @@ public:
      */
     static Errors::Code unlink(const char *path);
 
+    /**
+     * Invalidates the cached results of stat. This is done automatically for all changes that are
+     * made via VFS and for written files.
+     */
+    static void invalidate_cache() {
+        _cache.invalidate();
+    }
+
     /**
      * Prints the current mounts to <os>.
      *
@@ -133,6 +142,7 @@ public:
 private:
     static MountTable *ms();
     static Cleanup _cleanup;
+    static PathCache _cache;
 };
 
 }
@@ -50,15 +50,17 @@ Errors::Code Syscalls::send_receive_result(const void *msg, size_t size) {
     return Errors::last;
 }
 
-Errors::Code Syscalls::createsrv(capsel_t dst, capsel_t vpe, capsel_t rgate, const String &name) {
+Errors::Code Syscalls::createsrv(capsel_t dst, capsel_t vpe, capsel_t rgate, const String &name,
+                                 KIF::Syscall::SrvPolicy policy) {
     LLOG(SYSC, "createsrv(dst=" << dst << ", vpe=" << vpe
-        << ", rgate=" << rgate << ", name=" << name << ")");
+        << ", rgate=" << rgate << ", name=" << name << ", policy=" << policy << ")");
 
     KIF::Syscall::CreateSrv req;
     req.opcode = KIF::Syscall::CREATE_SRV;
     req.dst_sel = dst;
     req.vpe_sel = vpe;
     req.rgate_sel = rgate;
+    req.policy = policy;
     req.namelen = Math::min(name.length(), sizeof(req.name));
     memcpy(req.name, name.c_str(), req.namelen);
     size_t msgsize = sizeof(req) - sizeof(req.name) + req.namelen;
@@ -181,13 +183,14 @@ Errors::Code Syscalls::activate(capsel_t ep, capsel_t gate, goff_t addr) {
     return send_receive_result(&req, sizeof(req));
 }
 
-Errors::Code Syscalls::srvctrl(capsel_t srv, KIF::Syscall::SrvOp op) {
-    LLOG(SYSC, "srvctrl(srv=" << srv << ", op=" << op << ")");
+Errors::Code Syscalls::srvctrl(capsel_t srv, KIF::Syscall::SrvOp op, xfer_t arg) {
+    LLOG(SYSC, "srvctrl(srv=" << srv << ", op=" << op << ", arg=" << arg << ")");
 
     KIF::Syscall::SrvCtrl req;
     req.opcode = KIF::Syscall::SRV_CTRL;
     req.srv_sel = srv;
     req.op = static_cast<xfer_t>(op);
+    req.arg = arg;
     return send_receive_result(&req, sizeof(req));
 }
 
@@ -375,6 +378,26 @@ Errors::Code Syscalls::noop() {
     return send_receive_result(&req, sizeof(req));
 }
 
+Errors::Code Syscalls::syscstats(KIF::Syscall::Operation op, KIF::Syscall::SyscStatsReply *stats,
+                                 bool reset) {
+    LLOG(SYSC, "syscstats(op=" << op << ", reset=" << reset << ")");
+
+    KIF::Syscall::SyscStats req;
+    req.opcode = KIF::Syscall::SYSC_STATS;
+    req.op = op;
+    req.reset = reset;
+
+    DTU::Message *msg = send_receive(&req, sizeof(req));
+    auto *reply = reinterpret_cast<KIF::Syscall::SyscStatsReply*>(msg->data);
+
+    Errors::last = static_cast<Errors::Code>(reply->error);
+    if(Errors::last == Errors::NONE)
+        memcpy(stats, reply, sizeof(*stats));
+
+    DTU::get().mark_read(m3::DTU::SYSC_REP, reinterpret_cast<size_t>(msg));
+    return Errors::last;
+}
+
 // the USED seems to be necessary, because the libc calls it and LTO removes it otherwise
 USED void Syscalls::exit(int exitcode) {
     LLOG(SYSC, "exit(code=" << exitcode << ")");
@@ -141,8 +141,15 @@ Errors::Code VPE::exec(int argc, const char **argv) {
     senv.mounts_len = _ms->serialize(buffer + offset, RT_SPACE_SIZE - offset);
     offset = Math::round_up(offset + static_cast<size_t>(senv.mounts_len), sizeof(word_t));
 
+    // the file table grows on demand and might therefore not fit into the runtime space anymore
+    size_t space = Math::min(BUF_SIZE, static_cast<size_t>(RT_SPACE_SIZE));
+    if(offset > space || _fds->serialize_length() > space - offset) {
+        Heap::free(buffer);
+        return Errors::NO_SPACE;
+    }
+
     senv.fds = RT_SPACE_START + offset;
-    senv.fds_len = _fds->serialize(buffer + offset, RT_SPACE_SIZE - offset);
+    senv.fds_len = _fds->serialize(buffer + offset, space - offset);
     offset = Math::round_up(offset + static_cast<size_t>(senv.fds_len), sizeof(word_t));
 
     // map the memory first in case the VPE is not running and the kernel needs to forward the mem
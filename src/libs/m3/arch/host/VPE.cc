@@ -90,12 +90,14 @@ void VPE::init_fs() {
     if(read_from("ms", buf, len))
         _ms = MountTable::unserialize(buf, len);
 
-    len = STATE_BUF_SIZE;
-    memset(buf, 0, len);
-    if(read_from("fds", buf, len))
-        _fds = FileTable::unserialize(buf, len);
-
     delete[] buf;
+
+    // the size depends on the number of files; let read_from allocate the buffer
+    void *fds = read_from("fds", nullptr, len);
+    if(fds) {
+        _fds = FileTable::unserialize(fds, len);
+        Heap::free(fds);
+    }
 }
 
 Errors::Code VPE::run(void *lambda) {
@@ -144,7 +146,12 @@ Errors::Code VPE::run(void *lambda) {
         len = _ms->serialize(buf, len);
         write_file(pid, "ms", buf, len);
 
-        len = _fds->serialize(buf, STATE_BUF_SIZE);
+        delete[] buf;
+
+        // the file table grows on demand and might therefore not fit into the state buffer
+        len = Math::max(STATE_BUF_SIZE, _fds->serialize_length());
+        buf = new unsigned char[len];
+        len = _fds->serialize(buf, len);
         write_file(pid, "fds", buf, len);
 
         delete[] buf;
@@ -225,7 +232,12 @@ Errors::Code VPE::exec(int argc, const char **argv) {
         len = _ms->serialize(buf, STATE_BUF_SIZE);
         write_file(pid, "ms", buf, len);
 
-        len = _fds->serialize(buf, STATE_BUF_SIZE);
+        delete[] buf;
+
+        // the file table grows on demand and might therefore not fit into the state buffer
+        len = Math::max(STATE_BUF_SIZE, _fds->serialize_length());
+        buf = new unsigned char[len];
+        len = _fds->serialize(buf, len);
         write_file(pid, "fds", buf, len);
 
         delete[] buf;
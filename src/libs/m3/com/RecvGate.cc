@@ -164,14 +164,18 @@ void RecvGate::deactivate() {
 }
 
 void RecvGate::start(msghandler_t handler) {
+    _handler = handler;
+    start_with(new RecvGateWorkItem(this));
+}
+
+void RecvGate::start_with(RecvGateWorkItem *item) {
     activate();
 
     assert(&_vpe == &VPE::self());
     assert(!_workitem);
-    _handler = handler;
 
     bool permanent = ep() < DTU::FIRST_FREE_EP;
-    _workitem = new RecvGateWorkItem(this);
+    _workitem = item;
     env()->workloop()->add(_workitem, permanent);
 }
 
@@ -14,6 +14,8 @@
  * General Public License version 2 for more details.
  */
 
+#include <base/util/Math.h>
+
 #include <m3/session/M3FS.h>
 #include <m3/stream/FStream.h>
 #include <m3/vfs/VFS.h>
@@ -26,6 +28,7 @@ FStream::FStream(int fd, int perms, size_t bufsize, uint flags)
       _fd(fd),
       _rbuf(new File::Buffer((perms & FILE_R) ? bufsize : 0)),
       _wbuf(new File::Buffer((perms & FILE_W) ? bufsize : 0)),
+      _rsize(_rbuf->size),
       _flags(FL_DEL_BUF | flags) {
 }
 
@@ -41,6 +44,7 @@ FStream::FStream(const char *filename, size_t rsize, size_t wsize, int perms)
       _fd(VFS::open(filename, get_perms(perms))),
       _rbuf(_fd != FileTable::INVALID ? new File::Buffer((perms & FILE_R) ? rsize : 0) : nullptr),
       _wbuf(_fd != FileTable::INVALID ? new File::Buffer((perms & FILE_W) ? wsize : 0) : nullptr),
+      _rsize((perms & FILE_R) ? rsize : 0),
       _flags(FL_DEL_BUF | FL_DEL_FILE) {
     if(_fd == FileTable::INVALID)
         _state |= FL_ERROR;
@@ -75,12 +79,24 @@ size_t FStream::read(void *dst, size_t count) {
     // TODO maybe it's better to have just one buffer for both and track dirty regions?
     flush();
 
-    // use the unbuffered read, if the buffer is smaller
-    if(_rbuf->empty() && count > _rbuf->size) {
-        ssize_t res = file()->read(dst, count);
-        if(res <= 0)
-            set_error(res);
-        return res < 0 ? 0 : static_cast<size_t>(res);
+    if(count > 0 && count >= _rbuf->size) {
+        // hand out the buffered data first
+        size_t total = 0;
+        if(_rbuf->pos < _rbuf->cur) {
+            total = static_cast<size_t>(_rbuf->read(file(), dst, count));
+            count -= total;
+        }
+
+        // use the unbuffered read for the rest, if the buffer is smaller, to copy the data once
+        if(count > 0 && count >= _rbuf->size) {
+            _rbuf->invalidate();
+            ssize_t res = file()->read(static_cast<char*>(dst) + total, count);
+            if(res <= 0)
+                set_error(res);
+            else
+                total += static_cast<size_t>(res);
+        }
+        return total;
     }
 
     if(!_rbuf->buffer) {
@@ -88,6 +104,14 @@ size_t FStream::read(void *dst, size_t count) {
         return 0;
     }
 
+    // the last fill was consumed completely by small requests. if it filled the whole buffer, the
+    // file delivers more at once (up to the end of the extent), so that fewer transfers suffice.
+    if(adaptive() && _rbuf->cur == _rbuf->size && _rbuf->pos == _rbuf->cur &&
+       _rbuf->size < MAX_BUFSIZE) {
+        _rbuf->invalidate();
+        _rbuf->resize(_rbuf->size * 2);
+    }
+
     size_t total = 0;
     char *buf = reinterpret_cast<char*>(dst);
     while(count > 0) {
@@ -115,7 +139,9 @@ size_t FStream::seek(size_t offset, int whence) {
     if(error())
         return 0;
 
-    if(whence != M3FS_SEEK_CUR || offset != 0) {
+    // seek(0, SEEK_CUR) just asks for the position
+    bool moved = whence != M3FS_SEEK_CUR || offset != 0;
+    if(moved) {
         // TODO for simplicity, we always flush the write-buffer if we're changing the position
         flush();
     }
@@ -129,7 +155,12 @@ size_t FStream::seek(size_t offset, int whence) {
         _state |= FL_ERROR;
         return 0;
     }
+
+    // we've read ahead for nothing; start small again
+    bool wasted = moved && _rbuf->pos < _rbuf->cur;
     _rbuf->invalidate();
+    if(adaptive() && wasted && _rbuf->size > _rsize)
+        _rbuf->resize(Math::max(_rsize, _rbuf->size / 2));
     return static_cast<size_t>(res);
 }
 
@@ -137,11 +168,26 @@ size_t FStream::write(const void *src, size_t count) {
     if(bad())
         return 0;
 
-    // use the unbuffered write, if the buffer is smaller
-    if(_wbuf->empty() && count > _wbuf->size) {
-        ssize_t res = file()->write(src, count);
-        set_error(res);
-        return res < 0 ? 0 : static_cast<size_t>(res);
+    const char *buf = reinterpret_cast<const char*>(src);
+    size_t total = 0;
+
+    // use the unbuffered write, if the buffer is smaller, to copy the data only once
+    if(count >= _wbuf->size) {
+        if(!_wbuf->empty() && _wbuf->flush(file()) != Errors::NONE) {
+            _state |= FL_ERROR;
+            return 0;
+        }
+
+        while(count > 0) {
+            ssize_t res = file()->write(buf + total, count);
+            if(res <= 0) {
+                set_error(res);
+                break;
+            }
+            total += static_cast<size_t>(res);
+            count -= static_cast<size_t>(res);
+        }
+        return total;
     }
 
     if(!_wbuf->buffer) {
@@ -149,9 +195,16 @@ size_t FStream::write(const void *src, size_t count) {
         return 0;
     }
 
-    const char *buf = reinterpret_cast<const char*>(src);
-    size_t total = 0;
     while(count > 0) {
+        // a full buffer means that small writes follow each other; collect more of them at once
+        if(adaptive() && _wbuf->cur == _wbuf->size && _wbuf->size < MAX_BUFSIZE) {
+            if(_wbuf->flush(file()) != Errors::NONE) {
+                _state |= FL_ERROR;
+                return total;
+            }
+            _wbuf->resize(_wbuf->size * 2);
+        }
+
         ssize_t res = _wbuf->write(file(), buf + total, count);
         if(res <= 0) {
             set_error(res);
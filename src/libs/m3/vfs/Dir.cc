@@ -14,16 +14,117 @@
  * General Public License version 2 for more details.
  */
 
+#include <base/stream/OStringStream.h>
+
+#include <m3/session/M3FS.h>
 #include <m3/vfs/Dir.h>
+#include <m3/vfs/GenericFile.h>
+#include <m3/vfs/VFS.h>
+#include <m3/VPE.h>
 
 namespace m3 {
 
-bool Dir::readdir(Entry &e) {
-    // read header
-    DirEntry fse;
-    if(_f.read(&fse, sizeof(fse)) != sizeof(fse))
+Dir::~Dir() {
+    delete _batch;
+    if(_rgate) {
+        epid_t ep = _rgate->ep();
+        delete _rgate;
+        VPE::self().free_ep(ep);
+    }
+}
+
+bool Dir::readdir(Entry &e, FileInfo *info) {
+    const File *file = _f.file();
+    if(!file || file->type() != 'F')
+        return read_entry(e, info);
+
+    if(!_batch) {
+        _batch = new Batch();
+        _batch->reset();
+        _batch->attrs = false;
+    }
+
+    Batch &b = *_batch;
+    // the remaining entries lack the file information; fetch them again, including it
+    if(info && !b.attrs && b.pos < b.count) {
+        b.off = b.pos > 0 ? b.next[b.pos - 1] : b.start;
+        b.pos = b.count = 0;
+    }
+
+    if(b.pos == b.count) {
+        if(b.eof || !fetch(info != nullptr))
+            return false;
+    }
+
+    e = b.entries[b.pos];
+    if(info)
+        *info = b.infos[b.pos];
+    b.pos++;
+    return true;
+}
+
+bool Dir::fetch(bool attrs) {
+    Batch &b = *_batch;
+    GenericFile *file = static_cast<GenericFile*>(_f.file());
+
+    // use a separate receive gate for larger replies, if possible
+    if(!_rgate) {
+        epid_t ep = VPE::self().alloc_ep();
+        if(ep != 0) {
+            _rgate = new RecvGate(RecvGate::create(nextlog2<M3FS::READDIR_MSG_SIZE>::val,
+                                                   nextlog2<M3FS::READDIR_MSG_SIZE>::val));
+            _rgate->activate(ep);
+        }
+    }
+    RecvGate &rgate = _rgate ? *_rgate : RecvGate::def();
+    size_t max = (_rgate ? M3FS::READDIR_MSG_SIZE : DEF_RBUF_SIZE) - sizeof(DTU::Message::Header);
+
+    GateIStream reply = file->readdir(rgate, b.off, attrs, max);
+    reply >> Errors::last;
+    if(Errors::last != Errors::NONE)
         return false;
 
+    size_t count, next;
+    reply >> count >> next;
+    size_t n = Math::min(count, BATCH_SIZE);
+    for(size_t i = 0; i < n; ++i) {
+        Entry &e = b.entries[i];
+        inodeno_t ino;
+        size_t len;
+        reply >> ino >> b.next[i] >> len;
+        e.nodeno = ino;
+
+        // copy the name directly from the message
+        const char *name = reinterpret_cast<const char*>(reply.message().data + reply.pos());
+        size_t copy = Math::min(len, Entry::MAX_NAME_LEN - 1);
+        memcpy(e.name, name, copy);
+        e.name[copy] = '\0';
+        reply.ignore(Math::round_up(len, sizeof(xfer_t)));
+
+        if(attrs)
+            reply >> b.infos[i];
+    }
+
+    b.start = b.off;
+    b.off = n < count ? b.next[n - 1] : next;
+    b.pos = 0;
+    b.count = n;
+    b.eof = count == 0;
+    b.attrs = attrs;
+    return n > 0;
+}
+
+bool Dir::read_entry(Entry &e, FileInfo *info) {
+    // read header, skipping unused entries
+    DirEntry fse;
+    while(true) {
+        if(_f.read(&fse, sizeof(fse)) != sizeof(fse))
+            return false;
+        if(fse.namelen != 0)
+            break;
+        _f.seek(fse.next - sizeof(fse), M3FS_SEEK_CUR);
+    }
+
     // read name
     e.nodeno = fse.nodeno;
     if(_f.read(e.name, fse.namelen) != fse.namelen)
@@ -36,6 +137,14 @@ bool Dir::readdir(Entry &e) {
     size_t off = fse.next - (sizeof(fse) + fse.namelen);
     if(off != 0)
         _f.seek(off, M3FS_SEEK_CUR);
+
+    if(info) {
+        char path[128];
+        OStringStream os(path, sizeof(path));
+        os << _path << "/" << e.name;
+        if(VFS::stat(os.str(), *info) != Errors::NONE)
+            return false;
+    }
     return true;
 }
 
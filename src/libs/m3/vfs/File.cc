@@ -16,6 +16,8 @@
 
 #include <m3/vfs/File.h>
 
+#include <assert.h>
+
 namespace m3 {
 
 bool File::Buffer::putback(char c) {
@@ -26,6 +28,14 @@ bool File::Buffer::putback(char c) {
     return false;
 }
 
+void File::Buffer::resize(size_t _size) {
+    assert(cur == 0);
+    delete[] buffer;
+    buffer = _size ? new char[_size] : nullptr;
+    size = _size;
+    pos = 0;
+}
+
 ssize_t File::Buffer::read(File *file, void *dst, size_t amount) {
     if(pos < cur) {
         size_t count = Math::min(amount, cur - pos);
@@ -61,4 +71,64 @@ Errors::Code File::Buffer::flush(File *file) {
     return res;
 }
 
+ssize_t File::pread(void *buffer, size_t count, size_t offset) {
+    ssize_t old = seek(0, M3FS_SEEK_CUR);
+    if(old < 0 || seek(offset, M3FS_SEEK_SET) < 0)
+        return -1;
+
+    ssize_t res = read(buffer, count);
+    if(seek(static_cast<size_t>(old), M3FS_SEEK_SET) < 0)
+        return -1;
+    return res;
+}
+
+ssize_t File::pwrite(const void *buffer, size_t count, size_t offset) {
+    ssize_t old = seek(0, M3FS_SEEK_CUR);
+    if(old < 0 || seek(offset, M3FS_SEEK_SET) < 0)
+        return -1;
+
+    ssize_t res = write(buffer, count);
+    if(seek(static_cast<size_t>(old), M3FS_SEEK_SET) < 0)
+        return -1;
+    return res;
+}
+
+ssize_t File::readv(const IOVec *iov, size_t count) {
+    size_t total = 0;
+    for(size_t i = 0; i < count; ++i) {
+        char *buf = reinterpret_cast<char*>(iov[i].base);
+        size_t rem = iov[i].len;
+        while(rem > 0) {
+            ssize_t res = read(buf, rem);
+            if(res < 0)
+                return total > 0 ? static_cast<ssize_t>(total) : res;
+            if(res == 0)
+                return static_cast<ssize_t>(total);
+            buf += res;
+            rem -= static_cast<size_t>(res);
+            total += static_cast<size_t>(res);
+        }
+    }
+    return static_cast<ssize_t>(total);
+}
+
+ssize_t File::writev(const IOVec *iov, size_t count) {
+    size_t total = 0;
+    for(size_t i = 0; i < count; ++i) {
+        const char *buf = reinterpret_cast<const char*>(iov[i].base);
+        size_t rem = iov[i].len;
+        while(rem > 0) {
+            ssize_t res = write(buf, rem);
+            if(res < 0)
+                return total > 0 ? static_cast<ssize_t>(total) : res;
+            if(res == 0)
+                return static_cast<ssize_t>(total);
+            buf += res;
+            rem -= static_cast<size_t>(res);
+            total += static_cast<size_t>(res);
+        }
+    }
+    return static_cast<ssize_t>(total);
+}
+
 }
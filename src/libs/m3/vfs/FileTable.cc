@@ -15,6 +15,7 @@
  */
 
 #include <base/log/Lib.h>
+#include <base/util/Math.h>
 #include <base/Panic.h>
 
 #include <m3/com/Marshalling.h>
@@ -29,18 +30,56 @@
 
 namespace m3 {
 
+void FileTable::copy(const FileTable &f) {
+    delete[] _fds;
+    _fds = nullptr;
+    _fd_count = 0;
+    if(f._fd_count > 0) {
+        grow(f._fd_count);
+        for(fd_t i = 0; i < f._fd_count; ++i)
+            _fds[i] = f._fds[i];
+    }
+}
+
+void FileTable::grow(fd_t min) {
+    assert(min <= MAX_FDS);
+    fd_t count = Math::max(_fd_count > 0 ? _fd_count * 2 : INIT_FDS, min);
+    count = Math::min(count, MAX_FDS);
+
+    File **fds = new File*[static_cast<size_t>(count)];
+    for(fd_t i = 0; i < _fd_count; ++i)
+        fds[i] = _fds[i];
+    for(fd_t i = _fd_count; i < count; ++i)
+        fds[i] = nullptr;
+
+    LLOG(FILES, "Growing file table from " << _fd_count << " to " << count << " fds");
+    delete[] _fds;
+    _fds = fds;
+    _fd_count = count;
+}
+
 fd_t FileTable::alloc(File *file) {
-    for(fd_t i = 0; i < MAX_FDS; ++i) {
+    for(fd_t i = 0; i < _fd_count; ++i) {
         if(_fds[i] == nullptr) {
             file->set_fd(i);
             _fds[i] = file;
             return i;
         }
     }
-    return MAX_FDS;
+    if(_fd_count == MAX_FDS)
+        return MAX_FDS;
+
+    fd_t fd = _fd_count;
+    grow(fd + 1);
+    file->set_fd(fd);
+    _fds[fd] = file;
+    return fd;
 }
 
 File *FileTable::free(fd_t fd) {
+    if(fd >= _fd_count)
+        return nullptr;
+
     File *file = _fds[fd];
 
     // remove from multiplexing table
@@ -59,6 +98,16 @@ File *FileTable::free(fd_t fd) {
     return file;
 }
 
+bool FileTable::ep_available() const {
+    if(_file_ep_count < MAX_EPS)
+        return true;
+    for(size_t i = 0; i < MAX_EPS; ++i) {
+        if(_file_eps[i].file && !_file_eps[i].file->_ep_pinned)
+            return true;
+    }
+    return false;
+}
+
 epid_t FileTable::request_ep(GenericFile *file) {
     if(_file_ep_count < MAX_EPS) {
         epid_t ep = VPE::self().alloc_ep();
@@ -76,24 +125,40 @@ epid_t FileTable::request_ep(GenericFile *file) {
         }
     }
 
-    // TODO be smarter here
+    // take the EP from the file that transferred the least data recently. ties are broken
+    // round-robin, so that files with equal volume take turns. files with requests in flight
+    // need their EP until the reply has been received
+    size_t victim = MAX_EPS;
     size_t count = 0;
     for(size_t i = _file_ep_victim; count < MAX_EPS; i = (i + 1) % MAX_EPS, ++count) {
-        if(_file_eps[i].file != nullptr) {
-            LLOG(FILES, "FileEPs[" << i << "] = EP:" << _file_eps[i].epid << ", FD: switching from "
-                << _file_eps[i].file->fd() << " to " << file->fd());
-            _file_eps[i].file->evict();
-            _file_eps[i].file = file;
-            _file_ep_victim = (i + 1) % MAX_EPS;
-            return _file_eps[i].epid;
-        }
+        GenericFile *f = _file_eps[i].file;
+        if(f != nullptr && !f->_ep_pinned &&
+           (victim == MAX_EPS || f->_io_heat < _file_eps[victim].file->_io_heat))
+            victim = i;
     }
-    PANIC("Unable to find victim");
+    if(victim == MAX_EPS)
+        return 0;
+
+    GenericFile *old = _file_eps[victim].file;
+    LLOG(FILES, "FileEPs[" << victim << "] = EP:" << _file_eps[victim].epid << ", FD: switching from "
+        << old->fd() << " (heat=" << old->_io_heat << ") to " << file->fd());
+
+    // age the volumes, so that files that were busy long ago lose their claim
+    for(size_t i = 0; i < MAX_EPS; ++i) {
+        if(_file_eps[i].file)
+            _file_eps[i].file->_io_heat /= 2;
+    }
+    old->evict();
+    old->_ep_steals++;
+    _file_ep_steals++;
+    _file_eps[victim].file = file;
+    _file_ep_victim = (victim + 1) % MAX_EPS;
+    return _file_eps[victim].epid;
 }
 
 Errors::Code FileTable::delegate(VPE &vpe) const {
     Errors::Code res = Errors::NONE;
-    for(fd_t i = 0; i < MAX_FDS; ++i) {
+    for(fd_t i = 0; i < _fd_count; ++i) {
         if(_fds[i]) {
             res = _fds[i]->delegate(vpe);
             if(res != Errors::NONE)
@@ -107,13 +172,13 @@ size_t FileTable::serialize(void *buffer, size_t size) const {
     Marshaller m(static_cast<unsigned char*>(buffer), size);
 
     size_t count = 0;
-    for(fd_t i = 0; i < MAX_FDS; ++i) {
+    for(fd_t i = 0; i < _fd_count; ++i) {
         if(_fds[i])
             count++;
     }
 
     m << count;
-    for(fd_t i = 0; i < MAX_FDS; ++i) {
+    for(fd_t i = 0; i < _fd_count; ++i) {
         if(_fds[i]) {
             m << i << _fds[i]->type();
             _fds[i]->serialize(m);
@@ -122,6 +187,16 @@ size_t FileTable::serialize(void *buffer, size_t size) const {
     return m.total();
 }
 
+size_t FileTable::serialize_length() const {
+    size_t count = 0;
+    for(fd_t i = 0; i < _fd_count; ++i) {
+        if(_fds[i])
+            count++;
+    }
+    // the count and the fd, type and state of each file
+    return sizeof(xfer_t) + count * (2 * sizeof(xfer_t) + File::MAX_SERIAL_SIZE);
+}
+
 FileTable *FileTable::unserialize(const void *buffer, size_t size) {
     FileTable *obj = new FileTable();
     Unmarshaller um(static_cast<const unsigned char*>(buffer), size);
@@ -131,6 +206,8 @@ FileTable *FileTable::unserialize(const void *buffer, size_t size) {
         fd_t fd;
         char type;
         um >> fd >> type;
+        if(fd >= obj->_fd_count)
+            obj->grow(fd + 1);
         switch(type) {
             case 'F':
                 obj->_fds[fd] = GenericFile::unserialize(um);
@@ -21,6 +21,7 @@
 #include <m3/session/M3FS.h>
 #include <m3/vfs/FileTable.h>
 #include <m3/vfs/GenericFile.h>
+#include <m3/vfs/VFS.h>
 #include <m3/Syscalls.h>
 
 namespace m3 {
@@ -37,22 +38,57 @@ GenericFile::GenericFile(int flags, capsel_t caps, size_t id, epid_t mep, M3FS *
       _off(),
       _pos(),
       _len(),
-      _writing() {
+      _writing(),
+      _ra((flags & FILE_READAHEAD) && !(flags & FILE_NOSESS) ? RA_INIT : RA_OFF),
+      _ra_cur(),
+      _ra_rg(),
+      _ra_mg(MemGate::bind(ObjCap::INVALID)),
+      _ra_res(Errors::NONE),
+      _ra_off(),
+      _ra_len(),
+      _locoff(),
+      _locmem(),
+      _loclen(),
+      _locout(),
+      _win_sel(ObjCap::INVALID),
+      _win_idx(),
+      _win_count(),
+      _win_capoff(),
+      _win_len(),
+      _io_heat(),
+      _ep_steals(),
+      _ep_pinned() {
     if(mep != EP_COUNT)
         _mg.ep(mep);
 }
 
 GenericFile::~GenericFile() {
-    if(_writing)
-        submit();
-
     if(flags() & FILE_NOSESS) {
         LLOG(FS, "GenFile[" << fd() << "," << _id << "]::close()");
-        send_receive_vmsg(*_sg, M3FS::CLOSE_PRIV, _id);
+        // let the server commit the written data as part of the close
+        size_t nbytes = _writing ? _pos : 0;
+        send_receive_vmsg(*_sg, M3FS::CLOSE_PRIV, _id, nbytes);
+        if(nbytes > 0)
+            VFS::invalidate_cache();
         assert(_sess_obj);
         _sess_obj->free_ep(VPE::self().ep_to_sel(_mg.ep()));
     }
     else {
+        LLOG(FS, "GenFile[" << fd() << "," << _id << "]::close(ep_steals=" << _ep_steals << ")");
+        if(_writing)
+            submit();
+
+        if(_ra >= RA_IDLE) {
+            // wait for the outstanding reply before we free the receive gate
+            collect_readahead();
+            LLOG(FS, "GenFile[" << fd() << "," << _id << "]::revoke_ep(" << _ra_mg.ep() << ")");
+            capsel_t sel = VPE::self().ep_to_sel(_ra_mg.ep());
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sel), true);
+            VPE::self().free_ep(_ra_mg.ep());
+            epid_t rep = _ra_rg->ep();
+            delete _ra_rg;
+            VPE::self().free_ep(rep);
+        }
         if(_mg.ep() != MemGate::UNBOUND) {
             LLOG(FS, "GenFile[" << fd() << "," << _id << "]::revoke_ep(" << _mg.ep() << ")");
             capsel_t sel = VPE::self().ep_to_sel(_mg.ep());
@@ -66,6 +102,9 @@ GenericFile::~GenericFile() {
 Errors::Code GenericFile::stat(FileInfo &info) const {
     LLOG(FS, "GenFile[" << fd() << "," << _id << "]::stat()");
 
+    // the reply for an outstanding read-ahead request needs to be received first
+    collect_readahead();
+
     GateIStream reply = send_receive_vmsg(*_sg, STAT, _id);
     reply >> Errors::last;
     if(Errors::last == Errors::NONE)
@@ -73,6 +112,20 @@ Errors::Code GenericFile::stat(FileInfo &info) const {
     return Errors::last;
 }
 
+GateIStream GenericFile::readdir(RecvGate &rgate, size_t off, bool attrs, size_t max) {
+    LLOG(FS, "GenFile[" << fd() << "," << _id << "]::readdir(off=" << off << ", attrs=" << attrs << ")");
+
+    // the reply for an outstanding read-ahead request needs to be received first
+    collect_readahead();
+
+    RecvGate *old = _sg->reply_gate();
+    _sg->reply_gate(&rgate);
+    GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, M3FS::READDIR, _id, off, attrs, max)
+                                     : send_receive_vmsg(*_sg, M3FS::READDIR, off, attrs, max);
+    _sg->reply_gate(old);
+    return reply;
+}
+
 ssize_t GenericFile::seek(size_t offset, int whence) {
     LLOG(FS, "GenFile[" << fd() << "," << _id << "]::seek(" << offset << ", " << whence << ")");
 
@@ -103,7 +156,15 @@ ssize_t GenericFile::seek(size_t offset, int whence) {
             return -1;
     }
 
+    // the server position is set anyway; no need to restore it
+    if(cancel_readahead(false) != Errors::NONE)
+        return -1;
+
     // now seek on the server side
+    return server_seek(offset, whence);
+}
+
+ssize_t GenericFile::server_seek(size_t offset, int whence) {
     size_t off;
     GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, SEEK, _id, offset, whence)
                                      : send_receive_vmsg(*_sg, SEEK, offset, whence);
@@ -112,11 +173,17 @@ ssize_t GenericFile::seek(size_t offset, int whence) {
         return -1;
 
     reply >> _goff >> off;
+    _win_count = 0;
+    // the next extent starts at the requested position, not at the start of the extent
+    _goff += off;
     _pos = _len = 0;
-    return static_cast<ssize_t>(_goff + off);
+    return static_cast<ssize_t>(_goff);
 }
 
 bool GenericFile::send_next_input(label_t reply_label) {
+    // the server's position is behind the window, if we use one
+    if(_ra != RA_OFF || use_window())
+        return false;
     if(delegate_ep() != Errors::NONE)
         return false;
     if(_writing && submit() != Errors::NONE)
@@ -127,6 +194,7 @@ bool GenericFile::send_next_input(label_t reply_label) {
     if(_pos < _len)
         return false;
 
+    _loclen = 0;
     auto msg = create_vmsg(NEXT_IN, _id);
     _sg->send(msg.bytes(), msg.total(), reply_label);
     return true;
@@ -153,17 +221,52 @@ ssize_t GenericFile::read(void *buffer, size_t count) {
         << count << ", pos=" << (_goff + _pos) << ")");
 
     if(_pos == _len) {
-        Time::start(0xbbbb);
-        GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, NEXT_IN, _id)
-                                         : send_receive_vmsg(*_sg, NEXT_IN);
-        reply >> Errors::last;
-        Time::stop(0xbbbb);
-        if(Errors::last != Errors::NONE)
-            return -1;
+        if(_ra == RA_INIT)
+            init_readahead();
 
-        _goff += _len;
-        reply >> _off >> _len;
-        _pos = 0;
+        Time::start(0xbbbb);
+        if(_ra != RA_OFF) {
+            // usually, the next extent has been requested already
+            if(_ra == RA_IDLE && send_readahead() != Errors::NONE) {
+                Time::stop(0xbbbb);
+                return -1;
+            }
+            collect_readahead();
+            _ra = RA_IDLE;
+            Time::stop(0xbbbb);
+            Errors::last = _ra_res;
+            if(Errors::last != Errors::NONE)
+                return -1;
+
+            _goff += _len;
+            _off = _ra_off;
+            _len = _ra_len;
+            _pos = 0;
+            _ra_cur = !_ra_cur;
+
+            // request the next extent while this one is read
+            if(_len > 0)
+                send_readahead();
+        }
+        else if(use_window()) {
+            Errors::Code res = next_window_extent();
+            Time::stop(0xbbbb);
+            if(res != Errors::NONE)
+                return -1;
+        }
+        else {
+            _loclen = 0;
+            GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, NEXT_IN, _id)
+                                             : send_receive_vmsg(*_sg, NEXT_IN);
+            reply >> Errors::last;
+            Time::stop(0xbbbb);
+            if(Errors::last != Errors::NONE)
+                return -1;
+
+            _goff += _len;
+            reply >> _off >> _len;
+            _pos = 0;
+        }
     }
 
     size_t amount = Math::min(count, _len - _pos);
@@ -174,14 +277,114 @@ ssize_t GenericFile::read(void *buffer, size_t count) {
                 CPU::compute(count / 2);
         }
         else
-            _mg.read(buffer, amount, _memoff + _off + _pos);
+            cur_mem().read(buffer, amount, _memoff + _off + _pos);
         Time::stop(0xaaaa);
         _pos += amount;
+        _io_heat += amount;
+    }
+    return static_cast<ssize_t>(amount);
+}
+
+Errors::Code GenericFile::advise(size_t offset, size_t len, Advice advice) {
+    LLOG(FS, "GenFile[" << fd() << "," << _id << "]::advise(" << offset << ", " << len
+        << ", " << advice << ")");
+
+    // read-ahead doesn't pay off for random accesses
+    if(advice == RANDOM && _ra == RA_INIT)
+        _ra = RA_OFF;
+
+    // the reply for an outstanding read-ahead request needs to be received first
+    collect_readahead();
+
+    GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, M3FS::ADVISE, _id, offset, len, advice)
+                                     : send_receive_vmsg(*_sg, M3FS::ADVISE, offset, len, advice);
+    reply >> Errors::last;
+    return Errors::last;
+}
+
+ssize_t GenericFile::pread(void *buffer, size_t count, size_t offset) {
+    return access_at(buffer, count, offset, false);
+}
+
+ssize_t GenericFile::pwrite(const void *buffer, size_t count, size_t offset) {
+    ssize_t res = access_at(const_cast<void*>(buffer), count, offset, true);
+    // extending the file is left to write()
+    if(res == 0 && count > 0)
+        return File::pwrite(buffer, count, offset);
+    return res;
+}
+
+ssize_t GenericFile::access_at(void *buffer, size_t count, size_t offset, bool out) {
+    if(delegate_ep() != Errors::NONE)
+        return -1;
+    if(_writing && submit() != Errors::NONE)
+        return -1;
+
+    LLOG(FS, "GenFile[" << fd() << "," << _id << "]::" << (out ? "pwrite(" : "pread(")
+        << count << ", off=" << offset << ")");
+
+    MemGate *mg = &_mg;
+    size_t memoff, amount;
+    // reads within the current extent don't need the server
+    if(!out && offset >= _goff && offset < _goff + _len) {
+        mg = &cur_mem();
+        memoff = _off + (offset - _goff);
+        amount = Math::min(count, _goff + _len - offset);
+    }
+    else {
+        if(!(offset >= _locoff && offset < _locoff + _loclen && (!out || _locout))) {
+            Time::start(0xbbbb);
+            Errors::Code res = locate(offset, out);
+            Time::stop(0xbbbb);
+            if(res != Errors::NONE)
+                return -1;
+            if(_loclen == 0)
+                return 0;
+        }
+
+        memoff = _locmem + (offset - _locoff);
+        amount = Math::min(count, _locoff + _loclen - offset);
     }
+
+    Time::start(0xaaaa);
+    if(flags() & FILE_NODATA) {
+        if(count > 4)
+            CPU::compute(out ? count / 4 : count / 2);
+    }
+    else if(out)
+        mg->write(buffer, amount, _memoff + memoff);
+    else
+        mg->read(buffer, amount, _memoff + memoff);
+    Time::stop(0xaaaa);
+    _io_heat += amount;
     return static_cast<ssize_t>(amount);
 }
 
+Errors::Code GenericFile::locate(size_t offset, bool out) {
+    // the server continues at our position afterwards, so that the read-ahead is obsolete
+    cancel_readahead(false);
+
+    size_t cur = _goff + _pos;
+    GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, M3FS::LOCATE, _id, offset, out, cur)
+                                     : send_receive_vmsg(*_sg, M3FS::LOCATE, offset, out, cur);
+    reply >> Errors::last;
+    if(Errors::last != Errors::NONE)
+        return Errors::last;
+
+    // our EP covers the located range now instead of the current one
+    _goff = cur;
+    _pos = _len = 0;
+    _win_count = 0;
+    _ra_cur = false;
+    _locoff = offset;
+    _locout = out;
+    reply >> _locmem >> _loclen;
+    return Errors::NONE;
+}
+
 bool GenericFile::send_next_output(label_t reply_label) {
+    if(_ra != RA_OFF)
+        return false;
     if(delegate_ep() != Errors::NONE)
         return false;
 
@@ -190,6 +393,7 @@ bool GenericFile::send_next_output(label_t reply_label) {
     if(_pos < _len)
         return false;
 
+    _loclen = 0;
     auto msg = create_vmsg(NEXT_OUT, _id);
     _sg->send(msg.bytes(), msg.total(), reply_label);
     return true;
@@ -198,11 +402,15 @@ bool GenericFile::send_next_output(label_t reply_label) {
 ssize_t GenericFile::write(const void *buffer, size_t count) {
     if(delegate_ep() != Errors::NONE)
         return -1;
+    // the server moved on to the next extent, if we have requested it already
+    if(cancel_readahead(true) != Errors::NONE)
+        return -1;
 
     LLOG(FS, "GenFile[" << fd() << "," << _id << "]::write("
         << count << ", pos=" << (_goff + _pos) << ")");
 
     if(_pos == _len) {
+        _loclen = 0;
         Time::start(0xbbbb);
         GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, NEXT_OUT, _id)
                                          : send_receive_vmsg(*_sg, NEXT_OUT);
@@ -214,6 +422,7 @@ ssize_t GenericFile::write(const void *buffer, size_t count) {
         _goff += _len;
         reply >> _off >> _len;
         _pos = 0;
+        _ra_cur = false;
     }
 
     size_t amount = Math::min(count, _len - _pos);
@@ -224,9 +433,10 @@ ssize_t GenericFile::write(const void *buffer, size_t count) {
                 CPU::compute(count / 4);
         }
         else
-            _mg.write(buffer, amount, _memoff + _off + _pos);
+            cur_mem().write(buffer, amount, _memoff + _off + _pos);
         Time::stop(0xaaaa);
         _pos += amount;
+        _io_heat += amount;
     }
     _writing = true;
     return static_cast<ssize_t>(amount);
@@ -237,10 +447,17 @@ void GenericFile::evict() {
     assert(_mg.ep() != MemGate::UNBOUND);
     LLOG(FS, "GenFile[" << fd() << "," << _id << "]::evict()");
 
-    // submit read/written data
-    submit();
+    // the read-ahead request might target the EP we lose
+    cancel_readahead(true);
+
+    // submit read/written data. with a window, the server is behind it and has to be moved back
+    if(_win_count > 0)
+        server_seek(_goff + _pos, M3FS_SEEK_SET);
+    else
+        submit();
 
     // revoke EP cap
+    _loclen = 0;
     capsel_t ep_sel = VPE::self().ep_to_sel(_mg.ep());
     VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, ep_sel), true);
     _mg.ep(MemGate::UNBOUND);
@@ -253,19 +470,148 @@ Errors::Code GenericFile::submit() {
 
         GateIStream reply = !have_sess() ? send_receive_vmsg(*_sg, COMMIT, _id, _pos)
                                          : send_receive_vmsg(*_sg, COMMIT, _pos);
-        reply >> Errors::last;
-        if(Errors::last != Errors::NONE)
+        return received_commit_resp(reply);
+    }
+    _writing = false;
+    return Errors::NONE;
+}
+
+Errors::Code GenericFile::received_commit_resp(GateIStream &reply) {
+    reply >> Errors::last;
+    if(Errors::last != Errors::NONE)
+        return Errors::last;
+
+    // if we append, the file was truncated
+    size_t filesize;
+    reply >> filesize;
+    if(_goff + _len > filesize)
+        _len = filesize - _goff;
+    _goff += _pos;
+    _pos = _len = 0;
+    // the size and modification time have changed
+    if(_writing)
+        VFS::invalidate_cache();
+    _writing = false;
+    return Errors::NONE;
+}
+
+Errors::Code GenericFile::next_window_extent() {
+    if(_win_idx + 1 < _win_count)
+        _win_idx++;
+    else {
+        // request the next window, starting behind the current extent
+        if(_win_sel == ObjCap::INVALID)
+            _win_sel = VPE::self().alloc_sels(WINDOW_EXTS);
+
+        KIF::ExchangeArgs args;
+        args.count = 2;
+        args.vals[0] = _goff + _len;
+        args.vals[1] = WINDOW_EXTS;
+        KIF::CapRngDesc crd(KIF::CapRngDesc::OBJ, _win_sel, WINDOW_EXTS);
+        _win_count = 0;
+        if(_sess.obtain_for(VPE::self(), crd, &args) != Errors::NONE)
             return Errors::last;
 
-        // if we append, the file was truncated
-        size_t filesize;
-        reply >> filesize;
-        if(_goff + _len > filesize)
-            _len = filesize - _goff;
-        _goff += _pos;
-        _pos = _len = 0;
+        _win_idx = 0;
+        _win_count = Math::min(static_cast<size_t>(args.count - 1), WINDOW_EXTS);
+        _win_capoff = args.vals[0];
+        for(size_t i = 0; i < _win_count; ++i)
+            _win_len[i] = args.vals[1 + i];
+
+        LLOG(FS, "GenFile[" << fd() << "," << _id << "]::window(off=" << (_goff + _len)
+            << ", exts=" << _win_count << ")");
+
+        // end of file
+        if(_win_count == 0) {
+            _goff += _len;
+            _pos = _len = 0;
+            return Errors::NONE;
+        }
+    }
+
+    // switch to the extent ourself; this involves the kernel, but not the server
+    capsel_t ep_sel = VPE::self().ep_to_sel(_mg.ep());
+    if(Syscalls::get().activate(ep_sel, _win_sel + _win_idx, 0) != Errors::NONE)
+        return Errors::last;
+
+    _loclen = 0;
+    _goff += _len;
+    _off = _win_idx == 0 ? _win_capoff : 0;
+    _len = _win_len[_win_idx];
+    _pos = 0;
+    return Errors::NONE;
+}
+
+void GenericFile::init_readahead() {
+    // we need one EP for the second extent and one to receive the replies
+    epid_t mep = VPE::self().alloc_ep();
+    epid_t rep = mep != 0 ? VPE::self().alloc_ep() : 0;
+    if(rep == 0) {
+        if(mep != 0)
+            VPE::self().free_ep(mep);
+        _ra = RA_OFF;
+        return;
+    }
+
+    LLOG(FS, "GenFile[" << fd() << "," << _id << "]::init_readahead(mep=" << mep
+        << ", rep=" << rep << ")");
+
+    KIF::ExchangeArgs args;
+    args.count = 1;
+    args.vals[0] = 1;
+    KIF::CapRngDesc crd(KIF::CapRngDesc::OBJ, VPE::self().ep_to_sel(mep), 1);
+    if(_sess.delegate(crd, &args) != Errors::NONE) {
+        VPE::self().free_ep(mep);
+        VPE::self().free_ep(rep);
+        _ra = RA_OFF;
+        return;
+    }
+    _ra_mg.ep(mep);
+
+    // the default receive gate has only space for a single message as well
+    _ra_rg = new RecvGate(RecvGate::create(nextlog2<256>::val, nextlog2<256>::val));
+    _ra_rg->activate(rep);
+    _sg->reply_gate(_ra_rg);
+    _ra = RA_IDLE;
+}
+
+Errors::Code GenericFile::send_readahead() {
+    assert(_ra == RA_IDLE);
+    LLOG(FS, "GenFile[" << fd() << "," << _id << "]::readahead(ep=" << !_ra_cur << ")");
+
+    // let the server activate the next extent on the EP we don't use at the moment
+    size_t epidx = _ra_cur ? 0 : 1;
+    if(epidx == 0)
+        _loclen = 0;
+    Errors::last = send_vmsg(*_sg, NEXT_IN, epidx);
+    if(Errors::last == Errors::NONE)
+        _ra = RA_PENDING;
+    return Errors::last;
+}
+
+void GenericFile::collect_readahead() const {
+    if(_ra != RA_PENDING)
+        return;
+
+    GateIStream reply = receive_reply(*_sg);
+    reply >> _ra_res;
+    if(_ra_res == Errors::NONE)
+        reply >> _ra_off >> _ra_len;
+    _ra = RA_READY;
+}
+
+Errors::Code GenericFile::cancel_readahead(bool restore) {
+    if(_ra != RA_PENDING && _ra != RA_READY)
+        return Errors::NONE;
+
+    collect_readahead();
+    _ra = RA_IDLE;
+
+    // if the server handed out the next extent, it assumes that we've read the current one
+    if(restore && _ra_res == Errors::NONE && _ra_len > 0) {
+        if(server_seek(_goff + _pos, M3FS_SEEK_SET) == -1)
+            return Errors::last;
     }
-    _writing = false;
     return Errors::NONE;
 }
 
@@ -274,6 +620,9 @@ Errors::Code GenericFile::delegate_ep() {
         assert(!(flags() & FILE_NOSESS));
         epid_t ep = VPE::self().fds()->request_ep(this);
         LLOG(FS, "GenFile[" << fd() << "," << _id << "]::delegate_ep(" << ep << ")");
+        // all EPs are in use by requests in flight
+        if(ep == 0)
+            return Errors::last = Errors::NO_SPACE;
         _sess.delegate_obj(VPE::self().ep_to_sel(ep));
         if(Errors::last != Errors::NONE)
             return Errors::last;
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Lib.h>
+
+#include <m3/com/GateStream.h>
+#include <m3/session/M3FS.h>
+#include <m3/vfs/GenericFile.h>
+#include <m3/vfs/IOQueue.h>
+#include <m3/vfs/MountTable.h>
+#include <m3/vfs/VFS.h>
+#include <m3/VPE.h>
+
+namespace m3 {
+
+// the largest reply is the one for STAT
+static const size_t REPLY_SIZE = 256;
+
+IOQueue::IOQueue()
+    : _rgate(RecvGate::create(nextlog2<SLOTS * REPLY_SIZE>::val, nextlog2<REPLY_SIZE>::val)),
+      _slots(),
+      _seq(),
+      _pending(),
+      _inflight(),
+      _cq(),
+      _cqhead(),
+      _cqcount() {
+    _rgate.activate();
+}
+
+IOQueue::~IOQueue() {
+    // the replies for the requests in flight need to be received before the gate is gone
+    while(_inflight > 0)
+        receive();
+}
+
+bool IOQueue::push(Op op, fd_t fd, void *buf, size_t count, const char *path, int perms,
+                   word_t user) {
+    for(size_t i = 0; i < SLOTS; ++i) {
+        Slot &s = _slots[i];
+        if(s.state != FREE)
+            continue;
+
+        s.op = op;
+        s.fd = fd;
+        s.buf = buf;
+        s.count = count;
+        s.path = path;
+        s.pathpos = 0;
+        s.perms = perms;
+        s.user = user;
+        s.seq = _seq++;
+        s.gate = nullptr;
+        s.ep = ObjCap::INVALID;
+
+        // determine the gate now to keep the order of the requests for the same gate
+        if(op == OPEN) {
+            s.fs = VPE::self().mounts()->resolve(path, &s.pathpos);
+            if(s.fs.valid() && s.fs->type() == 'M' && (perms & FILE_NOSESS))
+                s.gate = &static_cast<M3FS*>(s.fs.get())->_gate;
+        }
+        else {
+            File *file = VPE::self().fds()->get(fd);
+            if(file && file->type() == 'F')
+                s.gate = static_cast<GenericFile*>(file)->_sg;
+        }
+
+        s.state = QUEUED;
+        _pending++;
+        return true;
+    }
+    return false;
+}
+
+bool IOQueue::blocked(size_t idx) const {
+    const Slot &s = _slots[idx];
+    if(s.gate == nullptr)
+        return false;
+
+    for(size_t i = 0; i < SLOTS; ++i) {
+        const Slot &o = _slots[i];
+        if(i == idx || o.gate != s.gate)
+            continue;
+        if(o.state == SENT || (o.state == QUEUED && o.seq < s.seq))
+            return true;
+    }
+
+    // reads and writes need a memory EP. if all are used by requests in flight, wait for them
+    if(s.op == READ || s.op == WRITE) {
+        FileTable *fds = VPE::self().fds();
+        GenericFile *file = static_cast<GenericFile*>(fds->get(s.fd));
+        if(file && file->have_sess() && file->_mg.ep() == MemGate::UNBOUND && !fds->ep_available())
+            return true;
+    }
+    return false;
+}
+
+size_t IOQueue::submit() {
+    while(true) {
+        // start the oldest request that can be started
+        size_t next = SLOTS;
+        for(size_t i = 0; i < SLOTS; ++i) {
+            if(_slots[i].state == QUEUED && !blocked(i) &&
+               (next == SLOTS || _slots[i].seq < _slots[next].seq))
+                next = i;
+        }
+        if(next == SLOTS)
+            break;
+
+        start(next);
+    }
+    return _inflight;
+}
+
+size_t IOQueue::wait(size_t min) {
+    submit();
+    while(_cqcount < min && _inflight > 0) {
+        receive();
+        submit();
+    }
+    return _cqcount;
+}
+
+bool IOQueue::complete(Completion &c) {
+    if(_cqcount == 0)
+        return false;
+
+    size_t idx = _cq[_cqhead];
+    _cqhead = (_cqhead + 1) % SLOTS;
+    _cqcount--;
+
+    Slot &s = _slots[idx];
+    c = s.result;
+    s.fs = Reference<FileSystem>();
+    s.state = FREE;
+    return true;
+}
+
+void IOQueue::start(size_t idx) {
+    Slot &s = _slots[idx];
+    if(s.op == OPEN) {
+        start_open(idx);
+        return;
+    }
+
+    File *file = VPE::self().fds()->get(s.fd);
+    if(!file) {
+        finish(idx, Errors::INV_ARGS, -1);
+        return;
+    }
+    if(s.gate) {
+        start_file(idx, static_cast<GenericFile*>(file));
+        return;
+    }
+
+    // not a GenericFile; do it synchronously
+    ssize_t res = 0;
+    switch(s.op) {
+        case READ:
+            res = file->read(s.buf, s.count);
+            break;
+        case WRITE:
+            res = file->write(s.buf, s.count);
+            break;
+        case COMMIT:
+            res = file->sync() == Errors::NONE ? 0 : -1;
+            break;
+        case STAT:
+            res = file->stat(*static_cast<FileInfo*>(s.buf)) == Errors::NONE ? 0 : -1;
+            break;
+        case OPEN:
+            UNREACHED;
+    }
+    finish(idx, res < 0 ? Errors::last : Errors::NONE, res);
+}
+
+void IOQueue::start_file(size_t idx, GenericFile *file) {
+    Slot &s = _slots[idx];
+    // replies for the read-ahead would interfere with ours
+    file->collect_readahead();
+
+    Errors::Code res = Errors::NONE;
+    switch(s.op) {
+        case READ:
+        case WRITE: {
+            // without a request, we can't do anything asynchronously
+            bool sent = false;
+            // the commit before reading is done synchronously over the file's own reply gate
+            if(s.op == READ && file->_writing && (res = file->submit()) != Errors::NONE) {
+                finish(idx, res, -1);
+                return;
+            }
+            if(!file->has_data()) {
+                RecvGate *old = s.gate->reply_gate();
+                s.gate->reply_gate(&_rgate);
+                sent = s.op == READ ? file->send_next_input(idx) : file->send_next_output(idx);
+                s.gate->reply_gate(old);
+            }
+            if(!sent) {
+                ssize_t amount = s.op == READ ? file->read(s.buf, s.count)
+                                              : file->write(s.buf, s.count);
+                finish(idx, amount < 0 ? Errors::last : Errors::NONE, amount);
+                return;
+            }
+            break;
+        }
+
+        case COMMIT:
+            if(!file->_writing || file->_pos == 0) {
+                res = file->submit();
+                finish(idx, res, res == Errors::NONE ? 0 : -1);
+                return;
+            }
+            if(file->have_sess()) {
+                auto msg = create_vmsg(GenericFile::COMMIT, file->_pos);
+                res = send(idx, *s.gate, msg.bytes(), msg.total());
+            }
+            else {
+                auto msg = create_vmsg(GenericFile::COMMIT, file->_id, file->_pos);
+                res = send(idx, *s.gate, msg.bytes(), msg.total());
+            }
+            break;
+
+        case STAT:
+            if(file->have_sess()) {
+                auto msg = create_vmsg(GenericFile::STAT);
+                res = send(idx, *s.gate, msg.bytes(), msg.total());
+            }
+            else {
+                auto msg = create_vmsg(GenericFile::STAT, file->_id);
+                res = send(idx, *s.gate, msg.bytes(), msg.total());
+            }
+            break;
+
+        case OPEN:
+            UNREACHED;
+    }
+
+    if(res != Errors::NONE) {
+        finish(idx, res, -1);
+        return;
+    }
+    // the server will use the EP and we use the send gate until the reply is there
+    file->_ep_pinned = true;
+    s.state = SENT;
+    _inflight++;
+}
+
+void IOQueue::start_open(size_t idx) {
+    Slot &s = _slots[idx];
+
+    // private m3fs files can be opened with a single message; everything else is done synchronously
+    if(s.gate) {
+        M3FS *fs = static_cast<M3FS*>(s.fs.get());
+        if(s.perms & (FILE_CREATE | FILE_TRUNC))
+            VFS::invalidate_cache();
+        s.ep = fs->alloc_ep();
+        if(s.ep != ObjCap::INVALID) {
+            auto msg = create_vmsg(M3FS::OPEN_PRIV, s.path + s.pathpos, s.perms, s.ep - fs->_eps);
+            Errors::Code res = send(idx, *s.gate, msg.bytes(), msg.total());
+            if(res == Errors::NONE) {
+                s.state = SENT;
+                _inflight++;
+                return;
+            }
+            fs->free_ep(s.ep);
+        }
+    }
+
+    fd_t fd = VFS::open(s.path, s.perms);
+    if(fd == FileTable::INVALID)
+        finish(idx, Errors::last, -1);
+    else
+        finish(idx, Errors::NONE, fd);
+}
+
+Errors::Code IOQueue::send(size_t idx, SendGate &gate, const void *msg, size_t size) {
+    RecvGate *old = gate.reply_gate();
+    gate.reply_gate(&_rgate);
+    Errors::Code res = gate.send(msg, size, idx);
+    gate.reply_gate(old);
+    return res;
+}
+
+void IOQueue::receive() {
+    const DTU::Message *msg;
+    Errors::Code err = _rgate.wait(nullptr, &msg);
+    if(err != Errors::NONE)
+        return;
+
+    GateIStream is(_rgate, msg);
+    size_t idx = is.label<size_t>();
+    Slot &s = _slots[idx];
+    assert(s.state == SENT);
+    _inflight--;
+
+    ssize_t res = 0;
+    if(s.op == OPEN) {
+        M3FS *fs = static_cast<M3FS*>(s.fs.get());
+        is >> Errors::last;
+        if(Errors::last != Errors::NONE) {
+            fs->free_ep(s.ep);
+            finish(idx, Errors::last, -1);
+            return;
+        }
+
+        size_t id;
+        is >> id;
+        File *file = new GenericFile(s.perms, fs->sel(), id, VPE::self().sel_to_ep(s.ep), fs);
+        fd_t fd = VPE::self().fds()->alloc(file);
+        if(fd == FileTable::INVALID) {
+            delete file;
+            finish(idx, Errors::NO_SPACE, -1);
+            return;
+        }
+        LLOG(FS, "GenFile[" << fd << "]::open(" << s.path << ", " << s.perms << ")");
+        if(s.perms & FILE_APPEND)
+            file->seek(0, M3FS_SEEK_END);
+        finish(idx, Errors::NONE, fd);
+        return;
+    }
+
+    GenericFile *file = static_cast<GenericFile*>(VPE::self().fds()->get(s.fd));
+    switch(s.op) {
+        case READ:
+        case WRITE:
+            // the next extent is available now; the rest is a local memory access
+            if(file->received_next_resp(is) == 0)
+                res = Errors::last == Errors::NONE ? 0 : -1;
+            else
+                res = s.op == READ ? file->read(s.buf, s.count) : file->write(s.buf, s.count);
+            break;
+
+        case COMMIT:
+            res = file->received_commit_resp(is) == Errors::NONE ? 0 : -1;
+            break;
+
+        case STAT:
+            is >> Errors::last;
+            if(Errors::last == Errors::NONE)
+                is >> *static_cast<FileInfo*>(s.buf);
+            res = Errors::last == Errors::NONE ? 0 : -1;
+            break;
+
+        case OPEN:
+            UNREACHED;
+    }
+    file->_ep_pinned = false;
+    finish(idx, res < 0 ? Errors::last : Errors::NONE, res);
+}
+
+void IOQueue::finish(size_t idx, Errors::Code err, ssize_t res) {
+    Slot &s = _slots[idx];
+    s.result.user = s.user;
+    s.result.err = err;
+    s.result.res = res;
+    s.state = DONE;
+    _pending--;
+
+    _cq[(_cqhead + _cqcount) % SLOTS] = idx;
+    _cqcount++;
+}
+
+}
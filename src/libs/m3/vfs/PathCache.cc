@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015-2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Lib.h>
+
+#include <m3/vfs/PathCache.h>
+
+#include <string.h>
+
+namespace m3 {
+
+size_t PathCache::hash(const char *path, size_t *len) {
+    // FNV-1a
+    size_t h = 2166136261u;
+    const char *p = path;
+    for(; *p; ++p)
+        h = (h ^ static_cast<uchar>(*p)) * 16777619u;
+    *len = static_cast<size_t>(p - path);
+    return h;
+}
+
+bool PathCache::get(const char *path, FileInfo &info, Errors::Code *res) {
+    _now++;
+
+    size_t len;
+    Entry &e = _entries[hash(path, &len) % ENTRIES];
+    if(e.expires <= _now || len >= MAX_PATH || strcmp(e.path, path) != 0)
+        return false;
+
+    LLOG(FS, "PathCache::get(" << path << ") -> " << Errors::to_string(e.res));
+    *res = e.res;
+    if(e.res == Errors::NONE)
+        info = e.info;
+    // other VPEs might create the file at any time, so don't rely on its absence for long
+    else
+        e.expires = 0;
+    return true;
+}
+
+void PathCache::put(const char *path, const FileInfo &info, Errors::Code res) {
+    if(res != Errors::NONE && res != Errors::NO_SUCH_FILE)
+        return;
+
+    size_t len;
+    Entry &e = _entries[hash(path, &len) % ENTRIES];
+    if(len >= MAX_PATH)
+        return;
+
+    memcpy(e.path, path, len + 1);
+    e.res = res;
+    if(res == Errors::NONE)
+        e.info = info;
+    e.expires = _now + LEASE;
+}
+
+void PathCache::invalidate() {
+    for(size_t i = 0; i < ENTRIES; ++i)
+        _entries[i].expires = 0;
+}
+
+}
@@ -29,9 +29,10 @@ namespace m3 {
 
 // clean them up after the standard streams have been destructed
 INIT_PRIO_VFS VFS::Cleanup VFS::_cleanup;
+INIT_PRIO_VFS PathCache VFS::_cache;
 
 VFS::Cleanup::~Cleanup() {
-    for(fd_t i = 0; i < FileTable::MAX_FDS; ++i)
+    for(fd_t i = 0; i < VPE::self().fds()->capacity(); ++i)
         delete VPE::self().fds()->free(i);
 }
 
@@ -45,10 +46,12 @@ Errors::Code VFS::mount(const char *path, const char *fs, const char *options) {
         fsobj = new M3FS(options ? options : fs);
     else
         return Errors::INV_ARGS;
+    _cache.invalidate();
     return ms()->add(path, fsobj);
 }
 
 void VFS::unmount(const char *path) {
+    _cache.invalidate();
     ms()->remove(path);
 }
 
@@ -61,6 +64,11 @@ Errors::Code VFS::delegate_eps(const char *path, capsel_t first, uint count) {
 }
 
 fd_t VFS::open(const char *path, int perms) {
+    // the cache is not coherent with other VPEs, so we always ask the filesystem here.
+    // creating or truncating changes the file's metadata
+    if(perms & (FILE_CREATE | FILE_TRUNC))
+        _cache.invalidate();
+
     size_t pos;
     Reference<FileSystem> fs = ms()->resolve(path, &pos);
     if(!fs.valid()) {
@@ -88,14 +96,21 @@ void VFS::close(fd_t fd) {
 }
 
 Errors::Code VFS::stat(const char *path, FileInfo &info) {
+    Errors::Code res;
+    if(_cache.get(path, info, &res))
+        return Errors::last = res;
+
     size_t pos;
     Reference<FileSystem> fs = ms()->resolve(path, &pos);
     if(!fs.valid())
         return Errors::last = Errors::NO_SUCH_FILE;
-    return fs->stat(path + pos, info);
+    res = fs->stat(path + pos, info);
+    _cache.put(path, info, res);
+    return res;
 }
 
 Errors::Code VFS::mkdir(const char *path, mode_t mode) {
+    _cache.invalidate();
     size_t pos;
     Reference<FileSystem> fs = ms()->resolve(path, &pos);
     if(!fs.valid())
@@ -104,6 +119,7 @@ Errors::Code VFS::mkdir(const char *path, mode_t mode) {
 }
 
 Errors::Code VFS::rmdir(const char *path) {
+    _cache.invalidate();
     size_t pos;
     Reference<FileSystem> fs = ms()->resolve(path, &pos);
     if(!fs.valid())
@@ -112,6 +128,7 @@ Errors::Code VFS::rmdir(const char *path) {
 }
 
 Errors::Code VFS::link(const char *oldpath, const char *newpath) {
+    _cache.invalidate();
     size_t pos1, pos2;
     Reference<FileSystem> fs1 = ms()->resolve(oldpath, &pos1);
     if(!fs1.valid())
@@ -125,6 +142,7 @@ Errors::Code VFS::link(const char *oldpath, const char *newpath) {
 }
 
 Errors::Code VFS::unlink(const char *path) {
+    _cache.invalidate();
     size_t pos;
     Reference<FileSystem> fs = ms()->resolve(path, &pos);
     if(!fs.valid())
@@ -118,6 +118,7 @@ pub struct CreateSrv {
     pub dst_sel: u64,
     pub vpe_sel: u64,
     pub rgate_sel: u64,
+    pub policy: u64,
     pub namelen: u64,
     pub name: [u8; MAX_STR_SIZE],
 }
@@ -223,6 +224,7 @@ pub struct SrvCtrl {
     pub opcode: u64,
     pub srv_sel: u64,
     pub op: u64,
+    pub arg: u64,
 }
 
 int_enum! {
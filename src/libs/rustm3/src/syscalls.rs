@@ -75,6 +75,7 @@ pub fn create_srv(dst: Selector, vpe: Selector, rgate: Selector, name: &str) ->
         dst_sel: dst as u64,
         vpe_sel: vpe as u64,
         rgate_sel: rgate as u64,
+        policy: 0,
         namelen: name.len() as u64,
         name: unsafe { intrinsics::uninit() },
     };
@@ -250,6 +251,7 @@ pub fn srv_ctrl(srv: Selector, op: syscalls::SrvOp) -> Result<(), Error> {
         opcode: syscalls::Operation::SRV_CTRL.val,
         srv_sel: srv as u64,
         op: op.val,
+        arg: 0,
     };
     send_receive_result(&req)
 }
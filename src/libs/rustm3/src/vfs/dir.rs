@@ -59,10 +59,20 @@ impl iter::Iterator for ReadDir {
             next: u32,
         }
 
-        // read header
-        let entry: M3FSDirEntry = match read_object(&mut self.reader) {
-            Ok(obj) => obj,
-            Err(_)  => return None,
+        // read header, skipping unused entries
+        let entry: M3FSDirEntry = loop {
+            let entry: M3FSDirEntry = match read_object(&mut self.reader) {
+                Ok(obj) => obj,
+                Err(_)  => return None,
+            };
+            if entry.name_len != 0 {
+                break entry;
+            }
+
+            let off = entry.next as usize - util::size_of::<M3FSDirEntry>();
+            if self.reader.seek(off, SeekMode::CUR).is_err() {
+                return None
+            }
         };
 
         // read name
@@ -62,6 +62,7 @@ pub struct FileInfo {
     // for debugging
     pub extents: u32,
     pub firstblock: BlockId,
+    pub flags: u32,
 }
 
 impl Marshallable for FileInfo {
@@ -75,6 +76,7 @@ impl Marshallable for FileInfo {
         s.push(&{self.lastmod});
         s.push(&{self.extents});
         s.push(&{self.firstblock});
+        s.push(&{self.flags});
     }
 }
 
@@ -90,6 +92,7 @@ impl Unmarshallable for FileInfo {
             lastmod:    s.pop_word() as u32,
             extents:    s.pop_word() as u32,
             firstblock: s.pop_word() as BlockId,
+            flags:      s.pop_word() as u32,
         }
     }
 }
@@ -48,7 +48,8 @@ static void export_rec(const char *dest, m3::inodeno_t dirno, const char *src) {
             m3::DirEntry *e = begin;
             while(e >= begin && e < end && e->next > 0) {
                 if(e->name + e->namelen <= reinterpret_cast<char*>(end)) {
-                    if((e->namelen != 1 || strncmp(e->name, ".", 1) != 0) &&
+                    if(e->namelen != 0 &&
+                        (e->namelen != 1 || strncmp(e->name, ".", 1) != 0) &&
                         (e->namelen != 2 || strncmp(e->name, "..", 2) != 0)) {
                         char epath[128];
                         snprintf(epath, sizeof(epath), "%s/%.*s", src, e->namelen, e->name);
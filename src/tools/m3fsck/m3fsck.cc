@@ -47,6 +47,9 @@ static void collect_blocks_and_inodes(m3::inodeno_t ino, m3::Bitmap &blocks, m3:
         errx(1, "Inode %u says that its inode-number is %u", ino, inode.inode);
 
     uint32_t block_count = (inode.size + sb.blocksize - 1) / sb.blocksize;
+    bool hashed = sb.hashed_dirs() && (inode.flags & m3::INODE_HASHED);
+    if(hashed && !M3FS_ISDIR(inode.mode))
+        errx(1, "Inode %u is hashed, but no directory", ino);
     if(M3FS_ISDIR(inode.mode)) {
         char *buffer = new char[sb.blocksize];
         for(uint32_t i = 0; i < block_count; ++i) {
@@ -64,7 +67,14 @@ static void collect_blocks_and_inodes(m3::inodeno_t ino, m3::Bitmap &blocks, m3:
             m3::DirEntry *end = reinterpret_cast<m3::DirEntry*>(buffer + sb.blocksize);
             // actually next is not allowed to be 0. but to prevent endless looping here...
             while(e->next > 0 && e < end) {
-                if(!(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
+                if(hashed && e->namelen != 0 &&
+                    m3::dir_bucket(m3::dir_hash(e->name, e->namelen), block_count) != i) {
+                    errx(1, "Entry '%.*s' of inode %u is in block %u instead of %zu", e->namelen,
+                            e->name, ino, i,
+                            m3::dir_bucket(m3::dir_hash(e->name, e->namelen), block_count));
+                }
+                if(e->namelen != 0 &&
+                    !(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
                     !(e->namelen == 2 && strncmp(e->name, "..", 2) == 0))
                     collect_blocks_and_inodes(e->nodeno, blocks, inodes);
                 e = reinterpret_cast<m3::DirEntry*>(reinterpret_cast<char*>(e) + e->next);
@@ -153,33 +153,103 @@ static m3::blockno_t store_blockno(const char *path, m3::INode *ino, m3::blockno
     return bno;
 }
 
-static m3::DirEntry *write_dirent(m3::INode *dir, m3::DirEntry *prev, const char *path,
-                                  const char *name, m3::inodeno_t inode, size_t &off,
-                                  m3::blockno_t &block) {
-    size_t len = strlen(name);
-    size_t total = sizeof(m3::DirEntry) + len;
-    if(off + total > sb.blocksize) {
-        prev->next += sb.blocksize - off;
-        write_to_block(prev, total, block, off - (sizeof(m3::DirEntry) + prev->namelen));
-
-        bool new_ext = blks_per_extent > 0 && ((dir->size / sb.blocksize) % blks_per_extent) == 0;
-        block = store_blockno(path, dir, alloc_block(new_ext), new_ext);
-        off = 0;
+struct HostDirEntry {
+    char *name;
+    size_t namelen;
+    m3::inodeno_t inode;
+};
+
+static size_t dirent_size(const HostDirEntry &e) {
+    return sizeof(m3::DirEntry) + e.namelen;
+}
+
+// determines the number of blocks with which no block of a hashed directory overflows
+static size_t hashed_blocks(const HostDirEntry *ents, size_t count) {
+    size_t total = 0;
+    for(size_t i = 0; i < count; ++i)
+        total += dirent_size(ents[i]);
+    size_t min = (total + sb.blocksize - 1) / sb.blocksize;
+    if(min == 0)
+        min = 1;
+
+    size_t *used = new size_t[min * 2 + 8];
+    size_t res = 0;
+    for(size_t blocks = min; res == 0 && blocks <= min * 2 + 8; ++blocks) {
+        memset(used, 0, blocks * sizeof(size_t));
+        res = blocks;
+        for(size_t i = 0; i < count; ++i) {
+            size_t b = m3::dir_bucket(m3::dir_hash(ents[i].name, ents[i].namelen), blocks);
+            used[b] += dirent_size(ents[i]);
+            if(used[b] > sb.blocksize) {
+                res = 0;
+                break;
+            }
+        }
+    }
+    delete[] used;
+    return res;
+}
+
+static void put_dirent(char *block, size_t *off, m3::DirEntry **last, const HostDirEntry &e) {
+    m3::DirEntry *entry = reinterpret_cast<m3::DirEntry*>(block + *off);
+    entry->nodeno = e.inode;
+    entry->namelen = e.namelen;
+    // the last entry spans the rest of the block
+    entry->next = sb.blocksize - *off;
+    memcpy(entry->name, e.name, e.namelen);
+    if(*last)
+        (*last)->next = static_cast<uint32_t>(reinterpret_cast<char*>(entry) - reinterpret_cast<char*>(*last));
+    *last = entry;
+    *off += dirent_size(e);
+}
+
+static void write_dir(const char *path, m3::INode *dir, const HostDirEntry *ents, size_t count) {
+    size_t blocks = hashed_blocks(ents, count);
+    if(blocks > 0)
+        dir->flags |= m3::INODE_HASHED;
+    else {
+        // the names don't spread; store them linearly
+        blocks = 0;
+        size_t off = sb.blocksize;
+        for(size_t i = 0; i < count; ++i) {
+            if(off + dirent_size(ents[i]) > sb.blocksize) {
+                blocks++;
+                off = 0;
+            }
+            off += dirent_size(ents[i]);
+        }
     }
 
-    m3::DirEntry *entry = (m3::DirEntry*)malloc(total);
-    if(!entry)
-        err(1, "malloc failed");
-    entry->nodeno = inode;
-    entry->namelen = len;
-    entry->next = sizeof(m3::DirEntry) + len;
-    memcpy(entry->name, name, len);
+    char *buffer = new char[blocks * sb.blocksize]();
+    size_t *offs = new size_t[blocks]();
+    m3::DirEntry **lasts = new m3::DirEntry*[blocks]();
+    size_t b = 0;
+    for(size_t i = 0; i < count; ++i) {
+        if(dir->flags & m3::INODE_HASHED)
+            b = m3::dir_bucket(m3::dir_hash(ents[i].name, ents[i].namelen), blocks);
+        else if(offs[b] + dirent_size(ents[i]) > sb.blocksize)
+            b++;
+        PRINT("Writing dir-entry %s/%s to block %zu+%zu\n", path, ents[i].name, b, offs[b]);
+        put_dirent(buffer + b * sb.blocksize, offs + b, lasts + b, ents[i]);
+    }
 
-    PRINT("Writing dir-entry %s/%s to %u+%zu\n", path, name, block, off);
+    for(b = 0; b < blocks; ++b) {
+        // empty blocks consist of an unused entry
+        if(!lasts[b]) {
+            m3::DirEntry *unused = reinterpret_cast<m3::DirEntry*>(buffer + b * sb.blocksize);
+            unused->nodeno = m3::INVALID_INO;
+            unused->namelen = 0;
+            unused->next = sb.blocksize;
+        }
 
-    write_to_block(entry, total, block, off);
-    off += total;
-    return entry;
+        bool new_ext = blks_per_extent > 0 && (b % blks_per_extent) == 0;
+        m3::blockno_t bno = store_blockno(path, dir, alloc_block(new_ext), new_ext);
+        write_to_block(buffer + b * sb.blocksize, sb.blocksize, bno);
+    }
+
+    delete[] lasts;
+    delete[] offs;
+    delete[] buffer;
 }
 
 static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
@@ -201,6 +271,7 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
     ino.inode = next_ino++;
     // TODO don't copy the number of links
     ino.links = st.st_nlink;
+    ino.flags = 0;
     ino.mode = st.st_mode;
     ino.lastaccess = static_cast<m3::time_t>(st.st_atim.tv_sec);
     ino.lastmod = static_cast<m3::time_t>(st.st_mtim.tv_sec);
@@ -230,19 +301,17 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
             err(1, "opendir of '%s' failed", path);
 
         struct dirent *e;
-        size_t diroff = 0;
-        m3::DirEntry *prev = nullptr, *newent = nullptr;
-        m3::blockno_t block = alloc_block(false);
-        ino.size = sb.blocksize;
-
-        ino.extents = 1;
-        ino.direct[0].start = block;
-        ino.direct[0].length = 1;
+        size_t count = 0, size = 16;
+        HostDirEntry *ents = static_cast<HostDirEntry*>(malloc(size * sizeof(HostDirEntry)));
+        if(!ents)
+            err(1, "malloc failed");
 
         while((e = readdir(d))) {
-            if(newent) {
-                free(prev);
-                prev = newent;
+            if(count == size) {
+                size *= 2;
+                ents = static_cast<HostDirEntry*>(realloc(ents, size * sizeof(HostDirEntry)));
+                if(!ents)
+                    err(1, "realloc failed");
             }
 
             m3::inodeno_t inode;
@@ -257,17 +326,18 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
                 delete[] epath;
             }
 
-            newent = write_dirent(&ino, prev, path, e->d_name, inode, diroff, block);
+            ents[count].name = strdup(e->d_name);
+            ents[count].namelen = strlen(e->d_name);
+            ents[count].inode = inode;
+            count++;
         }
+        closedir(d);
 
-        // set next of last entry to the end of the block
-        size_t newentlen = newent->next;
-        newent->next += sb.blocksize - diroff;
-        write_to_block(newent, newentlen, block, diroff - newentlen);
+        write_dir(path, &ino, ents, count);
 
-        free(newent);
-        free(prev);
-        closedir(d);
+        for(size_t i = 0; i < count; ++i)
+            free(ents[i].name);
+        free(ents);
     }
     else
         fprintf(stderr, "Warning: ignored file '%s' (no regular file or directory)\n", path);
@@ -301,6 +371,7 @@ int main(int argc,char **argv) {
     sb.total_inodes = strtoul(argv[4], nullptr, 0);
     sb.free_blocks = sb.total_blocks;
     sb.free_inodes = sb.total_inodes;
+    sb.features = m3::FEAT_DIR_HASH;
     blks_per_extent = strtoul(argv[5], nullptr, 0);
     use_rand = argc == 7 && strcmp(argv[6], "-rand");
     last_block = sb.first_data_block() - 1;
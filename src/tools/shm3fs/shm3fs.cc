@@ -39,6 +39,7 @@ static void print_sb() {
     printf("  free_blocks: %u\n", sb.free_blocks);
     printf("  first_free_inode: %u\n", sb.first_free_inode);
     printf("  first_free_block: %u\n", sb.first_free_block);
+    printf("  features: %#x\n", sb.features);
 }
 
 static void print_bitmap(uint32_t total, const m3::Bitmap &bitmap) {
@@ -99,6 +100,7 @@ static void print_inode(m3::inodeno_t ino, bool all) {
     printf("  inode: %u\n", inode.inode);
     printf("  mode: %#04o\n", inode.mode);
     printf("  links: %u\n", inode.links);
+    printf("  flags: %#x\n", inode.flags);
     printf("  size: %" PRIu64 "\n", inode.size);
     print_time(inode.lastaccess, "lastaccess");
     print_time(inode.lastmod, "lastmod");
@@ -225,7 +227,8 @@ static void print_tree(m3::inodeno_t dirno, const char *path, int level) {
                     printf("%*sino=%u len=%u next=%u name=%.*s\n",
                            (level + 1) * 2, "", e->nodeno, e->namelen, e->next, e->namelen, e->name);
 
-                    if((e->namelen != 1 || strncmp(e->name, ".", 1) != 0) &&
+                    if(e->namelen != 0 &&
+                        (e->namelen != 1 || strncmp(e->name, ".", 1) != 0) &&
                         (e->namelen != 2 || strncmp(e->name, "..", 2) != 0)) {
                         char epath[128];
                         snprintf(epath, sizeof(epath), "%s/%.*s", path, e->namelen, e->name);